@@ -0,0 +1,124 @@
+// SPDX-license-identifier: Apache-2.0
+// Copyright © 2021 Intel Corporation
+
+#include <algorithm>
+#include <unordered_map>
+
+#include "exceptions.hpp"
+#include "graph.hpp"
+
+namespace Backends::Common {
+
+namespace {
+
+/**
+ * A rough estimate of how expensive a rule is to run
+ *
+ * The absolute values don't matter, only how the rules compare. Without
+ * timings from a previous build, we assume links and precompiled headers
+ * cost a few compiles.
+ */
+uint64_t edge_cost(const Rule & rule) {
+    switch (rule.type) {
+        case RuleType::COMPILE:
+            return 2;
+        case RuleType::PCH:
+            return 4;
+        case RuleType::ARCHIVE:
+            return 1;
+        case RuleType::LINK:
+            return 4;
+        case RuleType::SCAN:
+        case RuleType::COLLATE:
+            return 1;
+    }
+    return 1;
+}
+
+} // namespace
+
+BuildGraph::BuildGraph(const std::vector<TargetRules> & rules) : nodes{}, edges{}, order{} {
+    std::unordered_map<std::string, std::size_t> node_ids{};
+    const auto get_node = [&](const std::string & path) {
+        auto && [it, inserted] = node_ids.try_emplace(path, nodes.size());
+        if (inserted) {
+            nodes.emplace_back(Node{path, std::nullopt, {}});
+        }
+        return it->second;
+    };
+
+    for (const auto & target : rules) {
+        for (const auto & r : target) {
+            const auto id = edges.size();
+            const auto add_output = [&](const std::string & path) {
+                const auto n = get_node(path);
+                if (nodes[n].producer.has_value()) {
+                    throw Util::Exceptions::MesonException{"Multiple rules generate " + path};
+                }
+                nodes[n].producer = id;
+                return n;
+            };
+            const auto out = add_output(r.output);
+            std::vector<std::size_t> implicit_outs{};
+            for (const auto & o : r.implicit_output) {
+                implicit_outs.emplace_back(add_output(o));
+            }
+            edges.emplace_back(Edge{&r, {}, out, std::move(implicit_outs), {}, {}, 0});
+        }
+    }
+
+    for (std::size_t i = 0; i < edges.size(); ++i) {
+        auto & edge = edges[i];
+        for (const auto * files : {&edge.rule->input, &edge.rule->implicit_input}) {
+            for (const auto & f : *files) {
+                const auto n = get_node(f);
+                edge.inputs.emplace_back(n);
+                nodes[n].consumers.emplace_back(i);
+                if (const auto & p = nodes[n].producer; p.has_value()) {
+                    edge.dependencies.emplace_back(p.value());
+                    edges[p.value()].dependents.emplace_back(i);
+                }
+            }
+        }
+    }
+
+    // Find a topological order, then walk it backwards so that every edge's
+    // dependents are weighed before it is.
+    std::vector<std::size_t> waiting(edges.size());
+    std::vector<std::size_t> topo{};
+    for (std::size_t i = 0; i < edges.size(); ++i) {
+        waiting[i] = edges[i].dependencies.size();
+        if (waiting[i] == 0) {
+            topo.emplace_back(i);
+        }
+    }
+    for (std::size_t i = 0; i < topo.size(); ++i) {
+        for (const auto & d : edges[topo[i]].dependents) {
+            if (--waiting[d] == 0) {
+                topo.emplace_back(d);
+            }
+        }
+    }
+    if (topo.size() != edges.size()) {
+        throw Util::Exceptions::MesonException{"Dependency cycle detected in build rules"};
+    }
+
+    for (auto it = topo.rbegin(); it != topo.rend(); ++it) {
+        auto & edge = edges[*it];
+        uint64_t longest = 0;
+        for (const auto & d : edge.dependents) {
+            longest = std::max(longest, edges[d].weight);
+        }
+        edge.weight = edge_cost(*edge.rule) + longest;
+    }
+
+    order.resize(edges.size());
+    for (std::size_t i = 0; i < edges.size(); ++i) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](const std::size_t & a, const std::size_t & b) {
+        return edges[a].weight > edges[b].weight;
+    });
+}
+
+} // namespace Backends::Common
@@ -0,0 +1,95 @@
+// SPDX-license-identifier: Apache-2.0
+// Copyright © 2021 Intel Corporation
+
+/**
+ * The build graph, connecting rules through the files they read and write
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "rules.hpp"
+
+namespace Backends::Common {
+
+/**
+ * A file in the build graph
+ */
+struct Node {
+    /// The path of the file, relative to the build directory
+    std::string path;
+
+    /// The edge that creates this file, if it isn't a source
+    std::optional<std::size_t> producer;
+
+    /// The edges that read this file
+    std::vector<std::size_t> consumers;
+};
+
+/**
+ * A rule in the build graph
+ */
+struct Edge {
+    /// The rule this edge runs
+    const Rule * rule;
+
+    /// The nodes this edge reads, including implicit inputs
+    std::vector<std::size_t> inputs;
+
+    /// The node this edge writes
+    std::size_t output;
+
+    /// Other nodes this edge writes
+    std::vector<std::size_t> implicit_outputs;
+
+    /// Edges that produce inputs of this edge
+    std::vector<std::size_t> dependencies;
+
+    /// Edges that read the output of this edge
+    std::vector<std::size_t> dependents;
+
+    /**
+     * The estimated cost of the longest chain of edges starting at this one
+     *
+     * Starting the edges with the highest weight first keeps long chains,
+     * such as a large library that many executables link, from being left
+     * until the end of the build.
+     */
+    uint64_t weight;
+};
+
+/**
+ * The rules of the build, as a graph of files and edges
+ *
+ * The rules are referred to, not copied, so they must outlive the graph.
+ */
+class BuildGraph {
+  public:
+    /**
+     * Build the graph
+     *
+     * @throws Util::Exceptions::MesonException if the rules contain a cycle
+     */
+    BuildGraph(const std::vector<TargetRules> & rules);
+
+    /// All of the files, in the order they are first seen
+    std::vector<Node> nodes;
+
+    /// All of the edges, in the same order as the rules
+    std::vector<Edge> edges;
+
+    /**
+     * Edge indexes, by descending weight
+     *
+     * An edge always weighs more than the edges that depend on it, so this is
+     * also a valid topological order. Edges of equal weight keep the order of
+     * the rules.
+     */
+    std::vector<std::size_t> order;
+};
+
+} // namespace Backends::Common
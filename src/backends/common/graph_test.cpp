@@ -0,0 +1,73 @@
+// SPDX-license-identifier: Apache-2.0
+// Copyright © 2021 Intel Corporation
+
+#include <gtest/gtest.h>
+
+#include "exceptions.hpp"
+#include "graph.hpp"
+
+using Backends::Common::Rule;
+using Backends::Common::RuleType;
+
+namespace {
+
+Rule make_rule(const std::vector<std::string> & in, const std::string & out, const RuleType & t) {
+    return Rule{in, out, t, MIR::Toolchain::Language::CPP, MIR::Machines::Machine::BUILD};
+}
+
+} // namespace
+
+TEST(build_graph, connections) {
+    const std::vector<Backends::Common::TargetRules> rules{{
+        make_rule({"a.cpp"}, "a.o", RuleType::COMPILE),
+        make_rule({"a.o"}, "a", RuleType::LINK),
+    }};
+    const Backends::Common::BuildGraph graph{rules};
+
+    ASSERT_EQ(graph.edges.size(), 2);
+    ASSERT_EQ(graph.nodes.size(), 3);
+    ASSERT_EQ(graph.edges[1].dependencies, std::vector<std::size_t>{0});
+    ASSERT_EQ(graph.edges[0].dependents, std::vector<std::size_t>{1});
+    ASSERT_FALSE(graph.nodes[graph.edges[0].inputs[0]].producer.has_value());
+    ASSERT_EQ(graph.nodes[graph.edges[1].inputs[0]].producer, 0);
+}
+
+TEST(build_graph, critical_path_first) {
+    // The library's chain is longer, so it should be started before the
+    // executable's, even though it comes later.
+    const std::vector<Backends::Common::TargetRules> rules{
+        {
+            make_rule({"main.cpp"}, "main.o", RuleType::COMPILE),
+            make_rule({"main.o"}, "prog", RuleType::LINK),
+        },
+        {
+            make_rule({"lib.cpp"}, "lib.o", RuleType::COMPILE),
+            make_rule({"lib.o"}, "lib.a", RuleType::ARCHIVE),
+            make_rule({"user.o", "lib.a"}, "user", RuleType::LINK),
+            make_rule({"user.cpp"}, "user.o", RuleType::COMPILE),
+        },
+    };
+    const Backends::Common::BuildGraph graph{rules};
+
+    ASSERT_EQ(graph.order.front(), 2);
+    ASSERT_GT(graph.edges[2].weight, graph.edges[0].weight);
+
+    // The order must be topological
+    std::vector<std::size_t> position(graph.order.size());
+    for (std::size_t i = 0; i < graph.order.size(); ++i) {
+        position[graph.order[i]] = i;
+    }
+    for (std::size_t i = 0; i < graph.edges.size(); ++i) {
+        for (const auto & d : graph.edges[i].dependencies) {
+            ASSERT_LT(position[d], position[i]);
+        }
+    }
+}
+
+TEST(build_graph, cycle) {
+    const std::vector<Backends::Common::TargetRules> rules{{
+        make_rule({"b"}, "a", RuleType::COMPILE),
+        make_rule({"a"}, "b", RuleType::COMPILE),
+    }};
+    ASSERT_THROW(Backends::Common::BuildGraph{rules}, Util::Exceptions::MesonException);
+}
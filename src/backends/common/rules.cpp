@@ -0,0 +1,383 @@
+// SPDX-license-identifier: Apache-2.0
+// Copyright © 2021 Intel Corporation
+
+#include <algorithm>
+#include <filesystem>
+#include <variant>
+
+#include "exceptions.hpp"
+#include "hash.hpp"
+#include "io.hpp"
+#include "rules.hpp"
+#include "target_cache.hpp"
+#include "threads.hpp"
+#include "trace.hpp"
+#include "toolchains/archiver.hpp"
+#include "toolchains/compiler.hpp"
+#include "toolchains/linker.hpp"
+
+namespace fs = std::filesystem;
+
+namespace Backends::Common {
+
+namespace {
+
+const std::string TARGET_POOL_PREFIX = "link_pool_";
+
+/**
+ * Write out a unity file
+ *
+ * This is only written if the contents have changed, otherwise every
+ * reconfigure would cause all of the unity files to be rebuilt.
+ */
+void write_unity_file(const fs::path & path, const std::string & contents) {
+    fs::create_directories(path.parent_path());
+    Util::write_if_changed(path, contents);
+}
+
+/**
+ * Whether the sources configure wrote for a target, like unity files, are still there
+ *
+ * These are the compiled sources inside of the build directory, which are only
+ * written when the target is lowered.
+ */
+bool generated_sources_exist(const TargetRules & rules, const fs::path & build_root) {
+    for (const auto & r : rules) {
+        if (r.type != RuleType::COMPILE) {
+            continue;
+        }
+        for (const auto & i : r.input) {
+            const fs::path p{i};
+            if (p.is_relative() && *p.begin() != ".." && !fs::exists(build_root / p)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/// A name for the target which is unique within the build
+template <typename T> std::string target_id(const T & e) {
+    if constexpr (std::is_base_of<MIR::Objects::StaticLibrary, T>::value) {
+        return "static_library:" + e.name;
+    } else {
+        return "executable:" + e.name;
+    }
+}
+
+/// Hash everything that the rules of a target are made from
+template <typename T> uint64_t target_key(const T & e, const uint64_t & global) {
+    Util::Hasher h{};
+    h.add(global);
+    h.add(target_id(e));
+    h.add(static_cast<uint64_t>(e.machine));
+    for (const auto & f : e.sources) {
+        h.add(f.relative_to_build_dir().string()).add(f.absolute_path().string());
+    }
+
+    for (const auto & [l, args] : e.arguments) {
+        h.add(static_cast<uint64_t>(l)).add(static_cast<uint64_t>(args.size()));
+        for (const auto & a : args) {
+            h.add(a.value).add(static_cast<uint64_t>(a.type));
+        }
+    }
+
+    h.add(static_cast<uint64_t>(e.link_pool_depth.has_value()));
+    h.add(static_cast<uint64_t>(e.link_pool_depth.value_or(0)));
+    h.add(static_cast<uint64_t>(e.cpp_pch.has_value()));
+    if (e.cpp_pch.has_value()) {
+        h.add(e.cpp_pch.value().relative_to_build_dir().string());
+    }
+    for (const auto & [k, v] : e.override_options) {
+        h.add(k).add(v);
+    }
+    h.add(static_cast<uint64_t>(e.install));
+    return h.digest();
+}
+
+template <typename T>
+std::vector<Rule> target_rule(const T & e, const MIR::State::Persistant & pstate) {
+    static_assert(std::is_base_of<MIR::Objects::Executable, T>::value ||
+                      std::is_base_of<MIR::Objects::StaticLibrary, T>::value,
+                  "Must be derived from a build target");
+
+    std::vector<std::string> cpp_args{};
+    if (e.arguments.find(MIR::Toolchain::Language::CPP) != e.arguments.end()) {
+        const auto & tc = pstate.toolchains.at(MIR::Toolchain::Language::CPP);
+        for (const auto & a : e.arguments.at(MIR::Toolchain::Language::CPP)) {
+            cpp_args.emplace_back(tc.build()->compiler->specialize_argument(a));
+        }
+    }
+
+    std::vector<Rule> rules{};
+    const auto & tc = pstate.toolchains.at(MIR::Toolchain::Language::CPP);
+    const auto & comp = tc.build()->compiler;
+
+    const auto opts = MIR::State::override_options(pstate.options, e.override_options);
+
+    auto lang_args = cpp_args;
+    const auto always_args = comp->always_args();
+    lang_args.insert(lang_args.end(), always_args.begin(), always_args.end());
+    if (opts.split_debug) {
+        const auto split_args = comp->split_debug_args();
+        lang_args.insert(lang_args.end(), split_args.begin(), split_args.end());
+    }
+
+    // Scanning only preprocesses, so it reads the header itself rather than
+    // the precompiled one
+    auto scan_args = lang_args;
+
+    // The precompiled header has to be built with the same arguments as the
+    // sources that use it, or it will be rejected.
+    std::vector<std::string> pch_deps{};
+    if (e.cpp_pch.has_value()) {
+        const auto & pch = e.cpp_pch.value();
+        const auto header = fs::path{e.name + ".p"} / fs::path{pch.get_name()}.filename();
+        const auto pch_out = header.string() + comp->pch_suffix();
+
+        rules.emplace_back(Rule{{pch.relative_to_build_dir()},
+                                pch_out,
+                                RuleType::PCH,
+                                MIR::Toolchain::Language::CPP,
+                                MIR::Machines::Machine::BUILD,
+                                lang_args});
+
+        for (auto && a : comp->use_pch_command(header)) {
+            lang_args.emplace_back(std::move(a));
+        }
+        for (auto && a : comp->use_pch_command(pch.relative_to_build_dir())) {
+            scan_args.emplace_back(std::move(a));
+        }
+        pch_deps.emplace_back(pch_out);
+    }
+
+    // The sources to compile, as (source, object) pairs
+    std::vector<std::pair<std::string, std::string>> units{};
+
+    // Module units can't be #included, so modules take precedence over unity
+    if (opts.unity && !opts.cpp_modules && e.sources.size() > 1) {
+        // Combine the sources into unity files which #include the real
+        // sources, and compile those instead.
+        const fs::path private_dir{e.name + ".p"};
+        for (std::size_t i = 0; i * opts.unity_size < e.sources.size(); ++i) {
+            const auto end = std::min<std::size_t>((i + 1) * opts.unity_size, e.sources.size());
+            std::string contents{};
+            for (std::size_t j = i * opts.unity_size; j < end; ++j) {
+                contents += "#include \"" + e.sources[j].absolute_path().string() + "\"\n";
+            }
+
+            const auto unity_name = (private_dir / ("unity_" + std::to_string(i) + ".cpp")).string();
+            write_unity_file(pstate.build_root / unity_name, contents);
+            units.emplace_back(unity_name, unity_name + ".o");
+        }
+    } else {
+        for (const auto & f : e.sources) {
+            // TODO: obj files are a per compiler thing, I think
+            // TODO: do something better for private dirs, we really need the subdir for this
+            units.emplace_back(f.relative_to_build_dir(),
+                               (fs::path{e.name + ".p"} / f.get_name()).string() + ".o");
+        }
+    }
+
+    // With modules every source is scanned for the modules it provides and
+    // requires, and the results for the whole target are collated into a
+    // dyndep file. Ninja reads that before compiling, to order the compiles
+    // and add the module interfaces as their outputs and inputs.
+    std::string dyndep{};
+    auto compile_deps = pch_deps;
+    if (opts.cpp_modules) {
+        const fs::path private_dir{e.name + ".p"};
+        dyndep = (private_dir / "modules.dd").string();
+        const auto map = (private_dir / "modules.map").string();
+
+        std::vector<std::string> ddis{};
+        for (const auto & [src, obj] : units) {
+            const auto ddi = obj + ".ddi";
+            auto args = scan_args;
+            for (auto && a : comp->module_scan_args(obj, ddi)) {
+                args.emplace_back(std::move(a));
+            }
+            rules.emplace_back(Rule{{src},
+                                    ddi,
+                                    RuleType::SCAN,
+                                    MIR::Toolchain::Language::CPP,
+                                    MIR::Machines::Machine::BUILD,
+                                    args});
+            ddis.emplace_back(ddi);
+        }
+
+        rules.emplace_back(Rule{ddis,
+                                {},
+                                dyndep,
+                                RuleType::COLLATE,
+                                MIR::Toolchain::Language::CPP,
+                                MIR::Machines::Machine::BUILD,
+                                {comp->id(), map},
+                                {map}});
+
+        for (auto && a : comp->module_map_args(map)) {
+            lang_args.emplace_back(std::move(a));
+        }
+        compile_deps.emplace_back(dyndep);
+    }
+
+    for (const auto & [src, obj] : units) {
+        std::vector<std::string> extra_outs{};
+        if (opts.split_debug) {
+            extra_outs.emplace_back(comp->split_debug_output(obj));
+        }
+        // TODO: get the proper language
+        rules.emplace_back(Rule{{src},
+                                compile_deps,
+                                obj,
+                                RuleType::COMPILE,
+                                MIR::Toolchain::Language::CPP,
+                                MIR::Machines::Machine::BUILD,
+                                lang_args,
+                                extra_outs,
+                                dyndep});
+    }
+
+    std::vector<std::string> final_outs;
+    for (const auto & r : rules) {
+        if (r.type == RuleType::COMPILE) {
+            final_outs.emplace_back(r.output);
+        }
+    }
+
+    std::string name;
+    RuleType type;
+    std::vector<std::string> link_args{};
+    std::string pool{};
+    if constexpr (std::is_base_of<MIR::Objects::StaticLibrary, T>::value) {
+        type = RuleType::ARCHIVE;
+        // TODO: per platform?
+        name = e.name + ".a";
+        // TODO: need to combin with link_arguments from DSL
+        const auto & ar = tc.build()->archiver;
+        // Archives that are only used within the build don't need copies of
+        // the objects
+        if (!e.install) {
+            link_args = ar->thin_args();
+        }
+        if (link_args.empty()) {
+            link_args = ar->always_args();
+        }
+        if (pstate.options.backend_max_archives != 0) {
+            pool = "archive_pool";
+        }
+    } else {
+        type = RuleType::LINK;
+        name = e.name;
+        link_args = tc.build()->linker->always_args();
+        if (opts.split_debug) {
+            const auto index_args = tc.build()->linker->gdb_index_args();
+            link_args.insert(link_args.end(), index_args.begin(), index_args.end());
+        }
+        if (pstate.options.backend_max_links != 0) {
+            pool = "link_pool";
+        }
+    }
+    if (e.link_pool_depth.has_value()) {
+        const auto & depth = e.link_pool_depth.value();
+        pool = depth == 0 ? "" : target_pool_name(depth);
+    }
+
+    // TODO: linker/archiver always_args
+
+    rules.emplace_back(Rule{
+        final_outs,
+        name,
+        type,
+        MIR::Toolchain::Language::CPP,
+        MIR::Machines::Machine::BUILD,
+        link_args,
+        pool,
+    });
+
+    return rules;
+}
+
+} // namespace
+
+std::string target_pool_name(const uint & depth) {
+    return TARGET_POOL_PREFIX + std::to_string(depth);
+}
+
+uint pool_depth(const std::string & pool, const MIR::State::BuiltinOptions & opts) {
+    if (pool == "link_pool") {
+        return opts.backend_max_links;
+    } else if (pool == "archive_pool") {
+        return opts.backend_max_archives;
+    } else if (pool.empty()) {
+        return 0;
+    }
+    return std::stoul(pool.substr(TARGET_POOL_PREFIX.size()));
+}
+
+bool needs_rsp(const Rule & rule) {
+    std::size_t len = 0;
+    for (const auto & i : rule.input) {
+        len += i.size() + 1;
+    }
+    for (const auto & a : rule.arguments) {
+        len += a.size() + 1;
+    }
+    return len > RSP_THRESHOLD;
+}
+
+std::vector<TargetRules> mir_to_rules(const MIR::BasicBlock * const block,
+                                      const MIR::State::Persistant & pstate,
+                                      TargetCache * cache) {
+    // Gather the targets up front, so that they can be lowered in parallel
+    std::vector<const MIR::Object *> targets{};
+    for (const auto & i : block->instructions) {
+        if (std::holds_alternative<std::unique_ptr<MIR::Executable>>(i) ||
+            std::holds_alternative<std::unique_ptr<MIR::StaticLibrary>>(i)) {
+            targets.emplace_back(&i);
+        }
+    }
+
+    const auto global = cache != nullptr ? global_key(pstate) : 0;
+
+    // A list of all rules, by target. Each worker only writes to its own
+    // slot, so the order is the same as if this were done serially
+    std::vector<TargetRules> rules(targets.size());
+    std::vector<std::string> ids(targets.size());
+    std::vector<uint64_t> keys(targets.size());
+    Util::parallel_for(targets.size(), [&](std::size_t n) {
+        const auto lower = [&](const auto & e) {
+            const Util::Trace::Span span{"lower target",
+                                         [&] { return Util::Trace::Args{{"target", e.name}}; }};
+            if (cache != nullptr) {
+                ids[n] = target_id(e);
+                keys[n] = target_key(e, global);
+                // Lowering again rewrites anything deleted from the private dir
+                if (const auto hit = cache->lookup(ids[n], keys[n]);
+                    hit != nullptr && generated_sources_exist(hit->rules, pstate.build_root)) {
+                    rules[n] = TargetRules(hit->rules);
+                    return;
+                }
+            }
+            rules[n] = target_rule(e, pstate);
+        };
+
+        const auto & i = *targets[n];
+        if (const auto x = std::get_if<std::unique_ptr<MIR::Executable>>(&i); x != nullptr) {
+            lower((*x)->value);
+        } else {
+            lower(std::get<std::unique_ptr<MIR::StaticLibrary>>(i)->value);
+        }
+    });
+
+    if (cache != nullptr) {
+        for (std::size_t n = 0; n < targets.size(); ++n) {
+            cache->store(ids[n], keys[n], rules[n]);
+        }
+    }
+
+    return rules;
+}
+
+
+} // namespace Backends::Common
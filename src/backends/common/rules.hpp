@@ -0,0 +1,139 @@
+// SPDX-license-identifier: Apache-2.0
+// Copyright © 2021 Intel Corporation
+
+/**
+ * Backend independent build rules
+ *
+ * These are the edges of the build, lowered from the MIR. The ninja backend
+ * writes them out as a manifest, and the executor runs them directly.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "meson/state/state.hpp"
+#include "mir.hpp"
+
+namespace Backends::Common {
+
+/**
+ * Maximum length of a command line before we switch to a response file
+ *
+ * Ninja runs commands via `sh -c`, so the whole command is a single argument
+ * and is limited by MAX_ARG_STRLEN (128k on Linux). Use half of that to leave
+ * plenty of room for the rule's fixed arguments.
+ */
+constexpr std::size_t RSP_THRESHOLD = 131072 / 2;
+
+enum class RuleType {
+    COMPILE,
+    PCH,
+    ARCHIVE,
+    LINK,
+    /// Scan a source for the modules it provides and requires
+    SCAN,
+    /// Combine the scan results of a target into a dyndep file
+    COLLATE,
+};
+
+/**
+ * A single edge of the build, to be written out or run later
+ */
+class Rule {
+  public:
+    Rule(const std::vector<std::string> & in, const std::string & out, const RuleType & r,
+         const MIR::Toolchain::Language & l, const MIR::Machines::Machine & m)
+        : input{in}, implicit_input{}, output{out}, implicit_output{}, type{r}, lang{l},
+          machine{m}, arguments{}, pool{}, dyndep{} {};
+    Rule(const std::vector<std::string> & in, const std::string & out, const RuleType & r,
+         const MIR::Toolchain::Language & l, const MIR::Machines::Machine & m,
+         const std::vector<std::string> & args)
+        : input{in}, implicit_input{}, output{out}, implicit_output{}, type{r}, lang{l},
+          machine{m}, arguments{args}, pool{}, dyndep{} {};
+    Rule(const std::vector<std::string> & in, const std::string & out, const RuleType & r,
+         const MIR::Toolchain::Language & l, const MIR::Machines::Machine & m,
+         const std::vector<std::string> & args, const std::string & p)
+        : input{in}, implicit_input{}, output{out}, implicit_output{}, type{r}, lang{l},
+          machine{m}, arguments{args}, pool{p}, dyndep{} {};
+    Rule(const std::vector<std::string> & in, const std::vector<std::string> & deps,
+         const std::string & out, const RuleType & r, const MIR::Toolchain::Language & l,
+         const MIR::Machines::Machine & m, const std::vector<std::string> & args,
+         const std::vector<std::string> & extra_outs = {}, const std::string & dd = "")
+        : input{in}, implicit_input{deps}, output{out}, implicit_output{extra_outs}, type{r},
+          lang{l}, machine{m}, arguments{args}, pool{}, dyndep{dd} {};
+    Rule(const std::vector<std::string> & in, const std::vector<std::string> & deps,
+         const std::string & out, const std::vector<std::string> & extra_outs,
+         const RuleType & r, const MIR::Toolchain::Language & l, const MIR::Machines::Machine & m,
+         const std::vector<std::string> & args, const std::string & p, const std::string & dd)
+        : input{in}, implicit_input{deps}, output{out}, implicit_output{extra_outs}, type{r},
+          lang{l}, machine{m}, arguments{args}, pool{p}, dyndep{dd} {};
+
+    /// The input for this rule
+    const std::vector<std::string> input;
+
+    /// Inputs that must be up to date before this rule runs, but aren't passed to it
+    const std::vector<std::string> implicit_input;
+
+    /// The output of this rule
+    const std::string output;
+
+    /// Other files written by this rule, which aren't passed to it
+    const std::vector<std::string> implicit_output;
+
+    /// The type of rule this is
+    const RuleType type;
+
+    /// The language of this rule
+    const MIR::Toolchain::Language lang;
+
+    /// The machine of this rule
+    const MIR::Machines::Machine machine;
+
+    /// The arguments for this rule
+    const std::vector<std::string> arguments;
+
+    /// The job pool this rule runs in, or empty for the default pool
+    const std::string pool;
+
+    /// A file with extra dependencies discovered at build time, which must also be an input
+    const std::string dyndep;
+};
+
+/// The rules for a single target, the rule for the target itself is last
+using TargetRules = std::vector<Rule>;
+
+/// Name of the pool for targets that override their link pool depth
+std::string target_pool_name(const uint & depth);
+
+/**
+ * The depth of a job pool
+ *
+ * @returns The maximum number of concurrent jobs in the pool, 0 means unlimited
+ */
+uint pool_depth(const std::string & pool, const MIR::State::BuiltinOptions & opts);
+
+/**
+ * Whether a rule's command line is long enough that it should use a response file
+ */
+bool needs_rsp(const Rule & rule);
+
+class TargetCache;
+
+/**
+ * Lower the build targets in a block into rules
+ *
+ * This also writes out any generated sources the rules need, such as unity
+ * files.
+ *
+ * @param cache If set, targets that haven't changed since the last configure
+ *              are taken from it rather than lowered again, and every target
+ *              is stored in it
+ */
+std::vector<TargetRules> mir_to_rules(const MIR::BasicBlock * const block,
+                                      const MIR::State::Persistant & pstate,
+                                      TargetCache * cache = nullptr);
+
+} // namespace Backends::Common
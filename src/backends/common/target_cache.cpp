@@ -0,0 +1,174 @@
+// SPDX-license-identifier: Apache-2.0
+// Copyright © 2021 Intel Corporation
+
+#include <array>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <sstream>
+
+#include "hash.hpp"
+#include "io.hpp"
+#include "serialize.hpp"
+#include "target_cache.hpp"
+#include "toolchains/archiver.hpp"
+#include "toolchains/compiler.hpp"
+#include "toolchains/linker.hpp"
+
+namespace fs = std::filesystem;
+
+namespace Backends::Common {
+
+namespace {
+
+/// The file magic, the last byte is the version of the format
+constexpr std::array<char, 8> MAGIC{'M', 'P', 'P', 'T', 'G', 'T', '\0', 1};
+
+void write_rule(std::ostream & out, const Rule & r) {
+    Util::write(out, r.input);
+    Util::write(out, r.implicit_input);
+    Util::write(out, r.output);
+    Util::write(out, r.implicit_output);
+    Util::write(out, static_cast<uint8_t>(r.type));
+    Util::write(out, static_cast<uint8_t>(r.lang));
+    Util::write(out, static_cast<uint8_t>(r.machine));
+    Util::write(out, r.arguments);
+    Util::write(out, r.pool);
+    Util::write(out, r.dyndep);
+}
+
+std::optional<Rule> read_rule(Util::Reader & reader) {
+    std::vector<std::string> input, implicit_input, implicit_output, arguments;
+    std::string output, pool, dyndep;
+    uint8_t type, lang, machine;
+    if (!reader.read(input) || !reader.read(implicit_input) || !reader.read(output) ||
+        !reader.read(implicit_output) || !reader.read(type) || !reader.read(lang) ||
+        !reader.read(machine) || !reader.read(arguments) || !reader.read(pool) ||
+        !reader.read(dyndep)) {
+        return std::nullopt;
+    }
+    return Rule{input,
+                implicit_input,
+                output,
+                implicit_output,
+                static_cast<RuleType>(type),
+                static_cast<MIR::Toolchain::Language>(lang),
+                static_cast<MIR::Machines::Machine>(machine),
+                arguments,
+                pool,
+                dyndep};
+}
+
+} // namespace
+
+TargetCache::TargetCache(const fs::path & p) : current{}, path{p}, previous{}, ids{} {
+    std::ifstream in{path, std::ios::binary};
+    if (!in.is_open()) {
+        return;
+    }
+    const std::string buf{std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{}};
+
+    Util::Reader reader{buf};
+    std::array<char, MAGIC.size()> magic;
+    if (!reader.read(magic) || magic != MAGIC) {
+        return;
+    }
+
+    std::unordered_map<std::string, Entry> loaded{};
+    while (!reader.done()) {
+        std::string id;
+        uint64_t key;
+        uint32_t count;
+        if (!reader.read(id) || !reader.read(key) || !reader.read(count)) {
+            return;
+        }
+        TargetRules rules{};
+        for (uint32_t i = 0; i < count; ++i) {
+            auto r = read_rule(reader);
+            if (!r.has_value()) {
+                return;
+            }
+            rules.emplace_back(std::move(r.value()));
+        }
+        std::vector<std::string> fragments{};
+        if (!reader.read(fragments) || fragments.size() != rules.size()) {
+            return;
+        }
+        loaded.insert_or_assign(std::move(id), Entry{key, std::move(rules), std::move(fragments)});
+    }
+
+    // Only use the cache if it was read completely
+    previous = std::move(loaded);
+}
+
+const TargetCache::Entry * TargetCache::lookup(const std::string & id,
+                                               const uint64_t & key) const {
+    const auto found = previous.find(id);
+    if (found == previous.end() || found->second.key != key) {
+        return nullptr;
+    }
+    return &found->second;
+}
+
+void TargetCache::store(const std::string & id, const uint64_t & key, const TargetRules & rules) {
+    std::vector<std::string> fragments(rules.size());
+    if (const auto prev = lookup(id, key); prev != nullptr) {
+        fragments = prev->fragments;
+    }
+    current.emplace_back(Entry{key, rules, std::move(fragments)});
+    ids.emplace_back(id);
+}
+
+void TargetCache::save() const {
+    std::ostringstream out{};
+    out.write(MAGIC.data(), MAGIC.size());
+    for (std::size_t i = 0; i < current.size(); ++i) {
+        const auto & e = current[i];
+        Util::write(out, ids[i]);
+        Util::write(out, e.key);
+        Util::write(out, static_cast<uint32_t>(e.rules.size()));
+        for (const auto & r : e.rules) {
+            write_rule(out, r);
+        }
+        Util::write(out, e.fragments);
+    }
+    Util::write_if_changed(path, out.str());
+}
+
+uint64_t global_key(const MIR::State::Persistant & pstate) {
+    Util::Hasher h{};
+    // A rebuilt meson++ may lower targets differently
+    std::error_code ec{};
+    if (const auto time = fs::last_write_time(pstate.program, ec); !ec) {
+        h.add(static_cast<uint64_t>(time.time_since_epoch().count()));
+        h.add(static_cast<uint64_t>(fs::file_size(pstate.program, ec)));
+    }
+    h.add(fs::absolute(pstate.source_root).string());
+    h.add(fs::absolute(pstate.build_root).string());
+    for (const auto & [k, v] : MIR::State::get_options(pstate.options)) {
+        h.add(k).add(v);
+    }
+
+    for (const auto & [l, tcs] : pstate.toolchains) {
+        // TODO: host toolchains, when there are any
+        const auto & tc = tcs.build();
+        h.add(static_cast<uint64_t>(l));
+
+        // The arguments picked by detection end up in the rendered rules too
+        const auto & comp = tc->compiler;
+        h.add(comp->id()).add(comp->command).add(comp->launcher).add(comp->always_args());
+        h.add(comp->split_debug_args()).add(comp->generate_depfile("${out}", "${out}.d"));
+
+        const auto & linker = tc->linker;
+        h.add(linker->id()).add(linker->command()).add(linker->always_args());
+        h.add(linker->gdb_index_args());
+
+        // An archiver may not have been found
+        if (const auto & ar = tc->archiver; ar != nullptr) {
+            h.add(ar->id()).add(ar->command()).add(ar->always_args()).add(ar->thin_args());
+        }
+    }
+    return h.digest();
+}
+
+} // namespace Backends::Common
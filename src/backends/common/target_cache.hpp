@@ -0,0 +1,82 @@
+// SPDX-license-identifier: Apache-2.0
+// Copyright © 2021 Intel Corporation
+
+/**
+ * Cache of lowered targets between configures
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "rules.hpp"
+
+namespace Backends::Common {
+
+/**
+ * The rules of each target from the previous configure, and the text the
+ * backend rendered them to
+ *
+ * Each target is stored with a key covering everything its rules are made
+ * from. If the key of a target hasn't changed, it doesn't need to be lowered
+ * or rendered again.
+ */
+class TargetCache {
+  public:
+    struct Entry {
+        /// A hash of everything the rules were made from
+        uint64_t key;
+
+        TargetRules rules;
+
+        /// The backend's rendering of each rule, or empty if it hasn't been rendered
+        std::vector<std::string> fragments;
+    };
+
+    /**
+     * Load the cache from the previous configure
+     *
+     * If it doesn't exist, or was written by a different version, the cache
+     * starts out empty.
+     */
+    TargetCache(const std::filesystem::path & path);
+
+    /// Get the previous entry for a target, if its key is unchanged
+    const Entry * lookup(const std::string & id, const uint64_t & key) const;
+
+    /**
+     * Add a target to this configure
+     *
+     * If the target's key is unchanged, the rendered fragments from the
+     * previous configure are kept.
+     */
+    void store(const std::string & id, const uint64_t & key, const TargetRules & rules);
+
+    /// Write out the targets of this configure, dropping those that no longer exist
+    void save() const;
+
+    /// The targets of this configure, in the order they were stored
+    std::vector<Entry> current;
+
+  private:
+    const std::filesystem::path path;
+
+    std::unordered_map<std::string, Entry> previous;
+
+    /// The ids of the current targets
+    std::vector<std::string> ids;
+};
+
+/**
+ * Hash everything that the rules of every target depend on
+ *
+ * Which is meson++ itself, the toolchains and the arguments detected for them,
+ * the built-in options, and the layout of the source and build directories.
+ */
+uint64_t global_key(const MIR::State::Persistant & pstate);
+
+} // namespace Backends::Common
@@ -0,0 +1,158 @@
+// SPDX-license-identifier: Apache-2.0
+// Copyright © 2021 Intel Corporation
+
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+
+#include "target_cache.hpp"
+#include "tempdir.hpp"
+#include "toolchains/archiver.hpp"
+#include "toolchains/compilers/cpp/cpp.hpp"
+#include "toolchains/linker.hpp"
+
+using Backends::Common::Rule;
+using Backends::Common::RuleType;
+using Backends::Common::TargetCache;
+
+namespace {
+
+class TargetCacheTest : public ::testing::Test {
+  protected:
+    const Util::TempDir tmp{"meson++-target-cache-test"};
+    const std::filesystem::path & dir = tmp.path();
+};
+
+const Backends::Common::TargetRules RULES{
+    Rule{{"../a.cpp"},
+         {"a.p/pch.hpp.gch"},
+         "a.p/a.cpp.o",
+         {"a.p/a.cpp.dwo"},
+         RuleType::COMPILE,
+         MIR::Toolchain::Language::CPP,
+         MIR::Machines::Machine::BUILD,
+         {"-DFOO", "-O2"},
+         "",
+         "a.p/modules.dd"},
+    Rule{{"a.p/a.cpp.o"},
+         "a",
+         RuleType::LINK,
+         MIR::Toolchain::Language::CPP,
+         MIR::Machines::Machine::BUILD,
+         {},
+         "link_pool"},
+};
+
+/// A state with only a C++ toolchain, using the given archiver
+MIR::State::Persistant
+make_state(std::unique_ptr<MIR::Toolchain::Archiver::Archiver> && archiver) {
+    namespace Toolchain = MIR::Toolchain;
+
+    MIR::State::Persistant pstate{"/src", "/build"};
+    const std::vector<std::string> init{"c++"};
+    auto comp = std::make_unique<Toolchain::Compiler::CPP::Gnu>(init);
+    const auto * c = comp.get();
+    pstate.toolchains[Toolchain::Language::CPP].set(
+        MIR::Machines::Machine::BUILD,
+        std::make_shared<Toolchain::Toolchain>(
+            std::move(comp),
+            std::make_unique<Toolchain::Linker::Drivers::Gnu>(
+                std::make_unique<Toolchain::Linker::GnuBFD>(init), c),
+            std::move(archiver)));
+    return pstate;
+}
+
+} // namespace
+
+TEST_F(TargetCacheTest, round_trip) {
+    {
+        TargetCache cache{dir / "cache"};
+        ASSERT_EQ(cache.lookup("executable:a", 1), nullptr);
+        cache.store("executable:a", 1, RULES);
+        ASSERT_EQ(cache.current.size(), 1);
+        ASSERT_EQ(cache.current[0].fragments, std::vector<std::string>(2));
+        cache.current[0].fragments = {"compile", "link"};
+        cache.save();
+    }
+
+    TargetCache cache{dir / "cache"};
+    ASSERT_EQ(cache.lookup("executable:a", 2), nullptr);
+    ASSERT_EQ(cache.lookup("executable:b", 1), nullptr);
+
+    const auto hit = cache.lookup("executable:a", 1);
+    ASSERT_NE(hit, nullptr);
+    ASSERT_EQ(hit->rules.size(), 2);
+    const auto & r = hit->rules[0];
+    ASSERT_EQ(r.input, RULES[0].input);
+    ASSERT_EQ(r.implicit_input, RULES[0].implicit_input);
+    ASSERT_EQ(r.output, RULES[0].output);
+    ASSERT_EQ(r.implicit_output, RULES[0].implicit_output);
+    ASSERT_EQ(r.type, RuleType::COMPILE);
+    ASSERT_EQ(r.arguments, RULES[0].arguments);
+    ASSERT_EQ(r.dyndep, RULES[0].dyndep);
+    ASSERT_EQ(hit->rules[1].type, RuleType::LINK);
+    ASSERT_EQ(hit->rules[1].pool, "link_pool");
+
+    // Fragments survive only if the key is the same
+    cache.store("executable:a", 1, RULES);
+    ASSERT_EQ(cache.current[0].fragments, (std::vector<std::string>{"compile", "link"}));
+    cache.store("executable:a", 2, RULES);
+    ASSERT_EQ(cache.current[1].fragments, std::vector<std::string>(2));
+}
+
+TEST_F(TargetCacheTest, dropped_targets) {
+    {
+        TargetCache cache{dir / "cache"};
+        cache.store("executable:a", 1, RULES);
+        cache.store("executable:b", 1, RULES);
+        cache.save();
+    }
+    {
+        TargetCache cache{dir / "cache"};
+        cache.store("executable:a", 1, RULES);
+        cache.save();
+    }
+    TargetCache cache{dir / "cache"};
+    ASSERT_NE(cache.lookup("executable:a", 1), nullptr);
+    ASSERT_EQ(cache.lookup("executable:b", 1), nullptr);
+}
+
+TEST_F(TargetCacheTest, corrupt) {
+    {
+        TargetCache cache{dir / "cache"};
+        cache.store("executable:a", 1, RULES);
+        cache.save();
+    }
+    const auto size = std::filesystem::file_size(dir / "cache");
+    std::filesystem::resize_file(dir / "cache", size - 3);
+
+    TargetCache cache{dir / "cache"};
+    ASSERT_EQ(cache.lookup("executable:a", 1), nullptr);
+
+    std::ofstream{dir / "cache", std::ios::trunc} << "not a cache";
+    ASSERT_EQ(TargetCache{dir / "cache"}.lookup("executable:a", 1), nullptr);
+}
+
+TEST_F(TargetCacheTest, archiver_thin_mode) {
+    using MIR::Toolchain::Archiver::Gnu;
+    using MIR::Toolchain::Archiver::ThinArchives;
+    const std::vector<std::string> ar{"ar"};
+
+    const auto option = Backends::Common::global_key(
+        make_state(std::make_unique<Gnu>(ar, ThinArchives::OPTION)));
+    {
+        TargetCache cache{dir / "cache"};
+        cache.store("static_library:a", option, RULES);
+        cache.save();
+    }
+
+    // An older ar takes the T modifier rather than --thin
+    const auto modifier = Backends::Common::global_key(
+        make_state(std::make_unique<Gnu>(ar, ThinArchives::MODIFIER)));
+    TargetCache cache{dir / "cache"};
+    ASSERT_NE(cache.lookup("static_library:a", option), nullptr);
+    ASSERT_EQ(cache.lookup("static_library:a", modifier), nullptr);
+
+    // Not finding an archiver at all is fine too
+    ASSERT_NE(Backends::Common::global_key(make_state(nullptr)), modifier);
+}
@@ -0,0 +1,114 @@
+// SPDX-license-identifier: Apache-2.0
+// Copyright © 2021 Intel Corporation
+
+#include <algorithm>
+#include <array>
+#include <vector>
+
+#include "build_log.hpp"
+#include "exceptions.hpp"
+#include "serialize.hpp"
+
+namespace fs = std::filesystem;
+
+namespace Backends::Executor {
+
+namespace {
+
+/// The file magic, the last byte is the version of the format
+constexpr std::array<char, 8> MAGIC{'M', 'P', 'P', 'L', 'O', 'G', '\0', 1};
+
+/// Rewrite the log once it has this many times more records than outputs
+constexpr std::size_t COMPACTION_RATIO = 3;
+
+void write_record(std::ostream & out, const std::string & output,
+                  const BuildLog::Entry & entry) {
+    Util::write(out, output);
+    Util::write(out, entry.command_hash);
+    Util::write(out, entry.deps);
+}
+
+} // namespace
+
+BuildLog::BuildLog(const fs::path & p) : path{p}, entries{}, out{}, lock{} {
+    if (load()) {
+        out.open(path, std::ios::binary | std::ios::app);
+    } else {
+        rewrite();
+    }
+    if (!out.is_open()) {
+        throw Util::Exceptions::MesonException{"Could not open build log " + path.string()};
+    }
+}
+
+bool BuildLog::load() {
+    std::ifstream in{path, std::ios::binary};
+    if (!in.is_open()) {
+        return false;
+    }
+    const std::string buf{std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{}};
+
+    Util::Reader reader{buf};
+    std::array<char, MAGIC.size()> magic;
+    if (!reader.read(magic) || magic != MAGIC) {
+        return false;
+    }
+
+    std::size_t records = 0;
+    while (!reader.done()) {
+        std::string output;
+        Entry entry{};
+        if (!reader.read(output) || !reader.read(entry.command_hash) ||
+            !reader.read(entry.deps)) {
+            return false;
+        }
+        entries.insert_or_assign(std::move(output), std::move(entry));
+        ++records;
+    }
+
+    return records <= entries.size() * COMPACTION_RATIO;
+}
+
+void BuildLog::rewrite() {
+    out.open(path, std::ios::binary | std::ios::trunc);
+    out.write(MAGIC.data(), MAGIC.size());
+
+    // Sort the records, so that a compacted log doesn't depend on hash order
+    std::vector<const std::pair<const std::string, Entry> *> sorted{};
+    sorted.reserve(entries.size());
+    for (const auto & e : entries) {
+        sorted.emplace_back(&e);
+    }
+    std::sort(sorted.begin(), sorted.end(),
+              [](const auto & a, const auto & b) { return a->first < b->first; });
+    for (const auto * e : sorted) {
+        write_record(out, e->first, e->second);
+    }
+    out.flush();
+}
+
+const BuildLog::Entry * BuildLog::lookup(const std::string & output) const {
+    const auto found = entries.find(output);
+    return found == entries.end() ? nullptr : &found->second;
+}
+
+void BuildLog::record(const std::string & output, Entry entry) {
+    std::lock_guard<std::mutex> guard{lock};
+    write_record(out, output, entry);
+    out.flush();
+    entries.insert_or_assign(output, std::move(entry));
+}
+
+uint64_t hash_command(const std::vector<std::string> & command) {
+    // FNV-1a, which is stable between runs, unlike std::hash
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (const auto & arg : command) {
+        for (const auto & c : arg) {
+            hash = (hash ^ static_cast<unsigned char>(c)) * 0x100000001b3ull;
+        }
+        hash = (hash ^ 0) * 0x100000001b3ull;
+    }
+    return hash;
+}
+
+} // namespace Backends::Executor
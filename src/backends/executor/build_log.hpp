@@ -0,0 +1,79 @@
+// SPDX-license-identifier: Apache-2.0
+// Copyright © 2021 Intel Corporation
+
+/**
+ * The executor's record of previous builds
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Backends::Executor {
+
+/**
+ * A compact, binary log of each output that has been built
+ *
+ * For every output this stores a hash of the command that produced it, so
+ * that changing arguments causes a rebuild, and the dependencies read from
+ * its depfile, so that depfiles don't have to be re-parsed on every build.
+ *
+ * The log is append only while building, with later records replacing
+ * earlier ones. It is rewritten without the stale records when it is opened
+ * if there are too many of them, or if the last write was interrupted.
+ */
+class BuildLog {
+  public:
+    /// What is known about an output
+    struct Entry {
+        /// A hash of the full command line used to build the output
+        uint64_t command_hash;
+
+        /// Files the output depends on, as discovered by the compiler
+        std::vector<std::string> deps;
+    };
+
+    /**
+     * Open a log, reading the existing contents if there are any
+     *
+     * An unreadable log, such as one from an incompatible version of Meson++,
+     * is discarded.
+     */
+    BuildLog(const std::filesystem::path & path);
+
+    /**
+     * Look up the entry for an output
+     *
+     * This is not safe to call concurrently with record()
+     *
+     * @returns A pointer to the entry, or nullptr if the output has never been built
+     */
+    const Entry * lookup(const std::string & output) const;
+
+    /**
+     * Record that an output was built, writing it out immediately
+     *
+     * This is safe to call concurrently
+     */
+    void record(const std::string & output, Entry entry);
+
+  private:
+    bool load();
+    void rewrite();
+
+    const std::filesystem::path path;
+    std::unordered_map<std::string, Entry> entries;
+    std::ofstream out;
+    std::mutex lock;
+};
+
+/// A stable hash of a command line, for storing in the build log
+uint64_t hash_command(const std::vector<std::string> & command);
+
+} // namespace Backends::Executor
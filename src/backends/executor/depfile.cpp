@@ -0,0 +1,66 @@
+// SPDX-license-identifier: Apache-2.0
+// Copyright © 2021 Intel Corporation
+
+#include "depfile.hpp"
+#include "exceptions.hpp"
+
+namespace Backends::Executor {
+
+namespace {
+
+bool is_space(const char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+
+} // namespace
+
+std::vector<std::string> parse_depfile(const std::string & contents) {
+    std::vector<std::string> deps{};
+    std::string current{};
+    bool seen_target = false;
+
+    const auto finish = [&]() {
+        if (current.empty()) {
+            return;
+        }
+        if (seen_target) {
+            deps.emplace_back(std::move(current));
+        }
+        current.clear();
+    };
+
+    for (std::size_t i = 0; i < contents.size(); ++i) {
+        const char c = contents[i];
+        const char next = i + 1 < contents.size() ? contents[i + 1] : '\0';
+
+        if (c == '\\' && (next == '\n' || next == '\r')) {
+            // Line continuation
+            finish();
+            ++i;
+            if (next == '\r' && i + 1 < contents.size() && contents[i + 1] == '\n') {
+                ++i;
+            }
+        } else if (c == '\\' && (next == ' ' || next == '#' || next == '\\')) {
+            current.push_back(next);
+            ++i;
+        } else if (c == '$' && next == '$') {
+            current.push_back('$');
+            ++i;
+        } else if (c == ':' && !seen_target && (is_space(next) || next == '\0')) {
+            // The end of the target, which we already know
+            current.clear();
+            seen_target = true;
+        } else if (is_space(c)) {
+            finish();
+        } else {
+            current.push_back(c);
+        }
+    }
+    finish();
+
+    if (!seen_target) {
+        throw Util::Exceptions::MesonException{"Malformed depfile, no target found"};
+    }
+
+    return deps;
+}
+
+} // namespace Backends::Executor
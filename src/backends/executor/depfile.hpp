@@ -0,0 +1,27 @@
+// SPDX-license-identifier: Apache-2.0
+// Copyright © 2021 Intel Corporation
+
+/**
+ * Reading of Makefile style dependency files, as written by `-MD`
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace Backends::Executor {
+
+/**
+ * Parse the dependencies out of a depfile
+ *
+ * Only the dependencies are returned, the target is discarded as there is
+ * only ever one, and we already know what it is.
+ *
+ * @param contents The contents of the depfile
+ * @returns The dependencies, in the order they were listed
+ * @throws Util::Exceptions::MesonException if the depfile is malformed
+ */
+std::vector<std::string> parse_depfile(const std::string & contents);
+
+} // namespace Backends::Executor
@@ -0,0 +1,562 @@
+// SPDX-license-identifier: Apache-2.0
+// Copyright © 2021 Intel Corporation
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <sys/stat.h>
+#include <thread>
+
+#include "build_log.hpp"
+#include "common/graph.hpp"
+#include "common/rules.hpp"
+#include "depfile.hpp"
+#include "exceptions.hpp"
+#include "executor.hpp"
+#include "process.hpp"
+#include "toolchains/compiler.hpp"
+
+namespace fs = std::filesystem;
+
+namespace Backends::Executor {
+
+namespace {
+
+using Common::Rule;
+using Common::RuleType;
+
+/// The name of the build log, relative to the build directory
+const std::string LOG_NAME = ".meson++.log";
+
+/**
+ * A rule, with everything needed to run it
+ */
+struct Edge {
+    /// The rule this edge runs
+    const Rule * rule;
+
+    /// The command to run
+    std::vector<std::string> command;
+
+    /// The contents of the response file, if this edge uses one
+    std::optional<std::string> rsp_content;
+
+    /// A hash of the full command, including anything in the response file
+    uint64_t hash;
+
+    /// A message describing what this edge does
+    std::string description;
+
+    /// Whether this edge needs to be run
+    bool dirty;
+};
+
+template <typename T> void extend(std::vector<std::string> & vec, const T & other) {
+    vec.insert(vec.end(), other.begin(), other.end());
+}
+
+/// Quote an argument for a GCC style response file
+std::string rsp_quote(const std::string & arg) {
+    std::string out{};
+    for (const auto & c : arg) {
+        if (c == ' ' || c == '\t' || c == '\n' || c == '\\' || c == '"' || c == '\'') {
+            out.push_back('\\');
+        }
+        out.push_back(c);
+    }
+    return out;
+}
+
+Edge make_edge(const Rule & rule, const MIR::State::Persistant & pstate) {
+    const auto & tc = pstate.toolchains.at(rule.lang).get(rule.machine);
+
+    std::vector<std::string> command{};
+    // The part of the command that goes in the response file, if one is used
+    std::vector<std::string> rsp_args{};
+    bool rsp_supported = false;
+    std::string description;
+
+    switch (rule.type) {
+        case RuleType::COMPILE:
+        case RuleType::PCH: {
+            const auto & c = tc->compiler;
+            extend(command, c->launcher);
+            extend(command, c->command);
+            extend(command, rule.arguments);
+            extend(command, c->generate_depfile(rule.output, rule.output + ".d"));
+            if (rule.type == RuleType::PCH) {
+                extend(command, c->precompile_header_command());
+                description = "Precompiling " + c->language() + " header " + rule.output;
+            } else {
+                description = "Compiling " + c->language() + " object " + rule.output;
+            }
+            extend(command, c->output_command(rule.output));
+            extend(command, c->compile_only_command());
+            extend(command, rule.input);
+            break;
+        }
+        case RuleType::ARCHIVE: {
+            const auto & a = tc->archiver;
+            extend(command, a->command());
+            extend(command, rule.arguments);
+            command.emplace_back(rule.output);
+            extend(rsp_args, rule.input);
+            rsp_supported = a->rsp_support() == MIR::Toolchain::RSPFileSupport::GCC;
+            description = "Linking static target " + rule.output;
+            break;
+        }
+        case RuleType::LINK: {
+            const auto & l = tc->linker;
+            extend(command, l->command());
+            extend(command, rule.arguments);
+            extend(command, l->output_command(rule.output));
+            extend(rsp_args, rule.input);
+            extend(rsp_args, rule.arguments);
+            rsp_supported = l->rsp_support() == MIR::Toolchain::RSPFileSupport::GCC;
+            description = "Linking target " + rule.output;
+            break;
+        }
+        case RuleType::SCAN:
+        case RuleType::COLLATE:
+            // TODO: the executor would need to load the dyndep files as it goes
+            throw Util::Exceptions::MesonException{
+                "C++ modules are not supported by the built in executor yet"};
+    }
+
+    std::vector<std::string> full = command;
+    extend(full, rsp_args);
+    const auto hash = hash_command(full);
+
+    std::optional<std::string> rsp_content{};
+    if (rsp_supported && Common::needs_rsp(rule)) {
+        std::string content{};
+        for (const auto & a : rsp_args) {
+            content += rsp_quote(a) + "\n";
+        }
+        rsp_content = std::move(content);
+        command.emplace_back("@" + rule.output + ".rsp");
+    } else {
+        command = std::move(full);
+    }
+
+    return Edge{&rule, std::move(command), std::move(rsp_content), hash, std::move(description),
+                false};
+}
+
+/// Get the mtime of a file in nanoseconds, or -1 if it doesn't exist
+int64_t mtime(const fs::path & path) {
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) {
+        return -1;
+    }
+    return static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+}
+
+/**
+ * Whether an edge's output is out of date
+ *
+ * This only considers the edge itself, an edge is also dirty if any of its
+ * dependencies are.
+ */
+bool is_stale(const Edge & edge, const BuildLog & log, const fs::path & build_root) {
+    const auto & rule = *edge.rule;
+    const auto out_time = mtime(build_root / rule.output);
+    if (out_time < 0) {
+        return true;
+    }
+
+    for (const auto & o : rule.implicit_output) {
+        if (mtime(build_root / o) < 0) {
+            return true;
+        }
+    }
+
+    const auto * entry = log.lookup(rule.output);
+    if (entry == nullptr || entry->command_hash != edge.hash) {
+        return true;
+    }
+
+    for (const auto * files : {&rule.input, &rule.implicit_input, &entry->deps}) {
+        for (const auto & f : *files) {
+            const auto t = mtime(build_root / f);
+            if (t < 0 || t > out_time) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+/// A job pool, limiting how many of its edges may run at once
+struct Pool {
+    /// The maximum number of concurrent edges, 0 means unlimited
+    uint depth;
+
+    /// The number of edges currently running
+    uint running;
+
+    /// Edges that are ready, but waiting for the pool to have room
+    std::deque<std::size_t> waiting;
+};
+
+/**
+ * Runs dirty edges with a work-stealing pool of threads
+ *
+ * Each worker has its own queue, which it pushes the edges it unblocks onto
+ * and takes work from the back of. A worker with an empty queue steals from
+ * the front of the others' queues. This keeps a chain of edges (a compile
+ * and the link waiting on it) on the same worker, while still spreading
+ * independent work evenly.
+ *
+ * Ready edges are queued so that those with the longest chain behind them
+ * are taken first.
+ *
+ * There is one worker per job, and each worker blocks on the process it
+ * started, so the number of threads is what limits the number of running
+ * processes. A single thread reaping every child would let fewer threads
+ * run more processes, but the workers would then have to hand each finished
+ * edge back to be completed, giving up the locality of the work stealing.
+ */
+class Scheduler {
+  public:
+    Scheduler(const Common::BuildGraph & g, std::vector<Edge> & e, const std::size_t & j,
+              const fs::path & root, BuildLog & l, std::map<std::string, Pool> && p)
+        : graph{g}, edges{e}, jobs{j}, build_root{root}, log{l}, pools{std::move(p)}, queues(j),
+          queue_locks(j), pending(e.size()), available{0}, remaining{0}, finished{0},
+          total{0}, stop{false}, failed{false}, error{nullptr} {};
+
+    /**
+     * Run all dirty edges
+     *
+     * @returns true if all of them succeeded
+     */
+    bool run() {
+        for (std::size_t i = 0; i < edges.size(); ++i) {
+            if (!edges[i].dirty) {
+                continue;
+            }
+            ++total;
+            for (const auto & d : graph.edges[i].dependencies) {
+                if (edges[d].dirty) {
+                    ++pending[i];
+                }
+            }
+        }
+        remaining = total;
+
+        // Workers take from the back of their own queue, so push the
+        // lightest edges first.
+        std::size_t next_queue = 0;
+        for (auto it = graph.order.rbegin(); it != graph.order.rend(); ++it) {
+            if (edges[*it].dirty && pending[*it] == 0) {
+                push(next_queue++ % jobs, *it);
+            }
+        }
+
+        std::vector<std::thread> workers{};
+        for (std::size_t i = 0; i < jobs; ++i) {
+            workers.emplace_back(&Scheduler::worker, this, i);
+        }
+        for (auto & w : workers) {
+            w.join();
+        }
+
+        if (error != nullptr) {
+            std::rethrow_exception(error);
+        }
+        return !failed;
+    }
+
+  private:
+    void worker(const std::size_t id) {
+        while (true) {
+            {
+                std::lock_guard<std::mutex> guard{state_lock};
+                if (stop) {
+                    return;
+                }
+            }
+
+            const auto next = pop(id);
+            if (!next.has_value()) {
+                std::unique_lock<std::mutex> guard{state_lock};
+                wake.wait(guard, [&] { return available > 0 || stop; });
+                continue;
+            }
+
+            const auto e = next.value();
+            if (!acquire(e)) {
+                // The pool is full, the edge will be queued again when it has room
+                continue;
+            }
+
+            bool ok = false;
+            try {
+                ok = execute(e);
+            } catch (...) {
+                std::lock_guard<std::mutex> guard{state_lock};
+                if (error == nullptr) {
+                    error = std::current_exception();
+                }
+            }
+            release(id, e);
+
+            if (ok) {
+                complete(id, e);
+            } else {
+                {
+                    std::lock_guard<std::mutex> guard{state_lock};
+                    failed = true;
+                    stop = true;
+                }
+                wake.notify_all();
+            }
+        }
+    }
+
+    void push(const std::size_t & id, const std::size_t & e) {
+        {
+            std::lock_guard<std::mutex> guard{queue_locks[id]};
+            queues[id].push_back(e);
+        }
+        {
+            std::lock_guard<std::mutex> guard{state_lock};
+            ++available;
+        }
+        wake.notify_one();
+    }
+
+    std::optional<std::size_t> pop(const std::size_t & id) {
+        for (std::size_t i = 0; i < jobs; ++i) {
+            const auto q = (id + i) % jobs;
+            std::optional<std::size_t> found{};
+            {
+                std::lock_guard<std::mutex> guard{queue_locks[q]};
+                if (queues[q].empty()) {
+                    continue;
+                }
+                if (q == id) {
+                    found = queues[q].back();
+                    queues[q].pop_back();
+                } else {
+                    found = queues[q].front();
+                    queues[q].pop_front();
+                }
+            }
+            std::lock_guard<std::mutex> guard{state_lock};
+            --available;
+            return found;
+        }
+        return std::nullopt;
+    }
+
+    /// Take a slot in the edge's pool, or queue the edge to wait for one
+    bool acquire(const std::size_t & e) {
+        const auto & name = edges[e].rule->pool;
+        if (name.empty()) {
+            return true;
+        }
+        std::lock_guard<std::mutex> guard{pool_lock};
+        auto & pool = pools.at(name);
+        if (pool.depth == 0 || pool.running < pool.depth) {
+            ++pool.running;
+            return true;
+        }
+        pool.waiting.emplace_back(e);
+        return false;
+    }
+
+    /// Give back a pool slot, and requeue an edge waiting for it
+    void release(const std::size_t & id, const std::size_t & e) {
+        const auto & name = edges[e].rule->pool;
+        if (name.empty()) {
+            return;
+        }
+        std::optional<std::size_t> waiting{};
+        {
+            std::lock_guard<std::mutex> guard{pool_lock};
+            auto & pool = pools.at(name);
+            --pool.running;
+            if (!pool.waiting.empty()) {
+                waiting = pool.waiting.front();
+                pool.waiting.pop_front();
+            }
+        }
+        if (waiting.has_value()) {
+            push(id, waiting.value());
+        }
+    }
+
+    /// Mark an edge as done, and queue any edges that were waiting on it
+    void complete(const std::size_t & id, const std::size_t & e) {
+        std::vector<std::size_t> ready{};
+        for (const auto & d : graph.edges[e].dependents) {
+            if (edges[d].dirty && --pending[d] == 0) {
+                ready.emplace_back(d);
+            }
+        }
+        std::sort(ready.begin(), ready.end(), [&](const std::size_t & a, const std::size_t & b) {
+            return graph.edges[a].weight < graph.edges[b].weight;
+        });
+        for (const auto & d : ready) {
+            push(id, d);
+        }
+        bool done;
+        {
+            std::lock_guard<std::mutex> guard{state_lock};
+            done = --remaining == 0;
+            if (done) {
+                stop = true;
+            }
+        }
+        if (done) {
+            wake.notify_all();
+        }
+    }
+
+    /// Run a single edge, returning whether it succeeded
+    bool execute(const std::size_t & e) {
+        const auto & edge = edges[e];
+        const auto & rule = *edge.rule;
+        const auto output = build_root / rule.output;
+
+        fs::create_directories(output.parent_path());
+        const auto rsp = build_root / (rule.output + ".rsp");
+        if (edge.rsp_content.has_value()) {
+            std::ofstream{rsp, std::ios::trunc} << edge.rsp_content.value();
+        }
+        if (rule.type == RuleType::ARCHIVE) {
+            // ar adds to an existing archive rather than replacing it
+            fs::remove(output);
+        }
+
+        // Blocking here is what holds this worker's job slot
+        Util::Subprocess proc{edge.command, build_root};
+        const auto [ret, out] = proc.wait();
+
+        {
+            std::lock_guard<std::mutex> guard{print_lock};
+            std::cout << "[" << ++finished << "/" << total << "] " << edge.description << "\n";
+            if (ret != 0) {
+                std::cout << "FAILED: " << rule.output << "\n";
+                for (const auto & c : edge.command) {
+                    std::cout << c << " ";
+                }
+                std::cout << "\n";
+            }
+            std::cout << out << std::flush;
+        }
+        if (ret != 0) {
+            return false;
+        }
+
+        // Move the dependencies out of the depfile and into the log, like
+        // ninja's `deps = gcc`.
+        std::vector<std::string> deps{};
+        if (rule.type == RuleType::COMPILE || rule.type == RuleType::PCH) {
+            const auto depfile = build_root / (rule.output + ".d");
+            std::ifstream in{depfile};
+            if (in.is_open()) {
+                const std::string contents{std::istreambuf_iterator<char>{in},
+                                           std::istreambuf_iterator<char>{}};
+                in.close();
+                deps = parse_depfile(contents);
+                fs::remove(depfile);
+            }
+        }
+        log.record(rule.output, BuildLog::Entry{edge.hash, std::move(deps)});
+
+        if (edge.rsp_content.has_value()) {
+            fs::remove(rsp);
+        }
+        return true;
+    }
+
+    const Common::BuildGraph & graph;
+    std::vector<Edge> & edges;
+    const std::size_t jobs;
+    const fs::path & build_root;
+    BuildLog & log;
+
+    std::map<std::string, Pool> pools;
+    std::mutex pool_lock;
+
+    std::vector<std::deque<std::size_t>> queues;
+    std::vector<std::mutex> queue_locks;
+
+    /// The number of dirty dependencies each edge is still waiting on
+    std::vector<std::atomic<std::size_t>> pending;
+
+    /// Protects available, remaining, stop, failed, and error
+    std::mutex state_lock;
+    std::condition_variable wake;
+    std::ptrdiff_t available;
+    std::size_t remaining;
+
+    std::mutex print_lock;
+    std::size_t finished;
+    std::size_t total;
+
+    bool stop;
+    bool failed;
+    std::exception_ptr error;
+};
+
+} // namespace
+
+bool build(const MIR::BasicBlock * const block, const MIR::State::Persistant & pstate,
+           const uint & jobs) {
+    fs::create_directories(pstate.build_root);
+    const auto rules = Common::mir_to_rules(block, pstate);
+
+    const Common::BuildGraph graph{rules};
+
+    std::vector<Edge> edges{};
+    for (const auto & e : graph.edges) {
+        edges.emplace_back(make_edge(*e.rule, pstate));
+    }
+
+    // An edge is dirty if it is stale itself, or if anything it depends on
+    // is going to be rebuilt.
+    BuildLog log{pstate.build_root / LOG_NAME};
+    std::size_t dirty = 0;
+    for (const auto & i : graph.order) {
+        auto & edge = edges[i];
+        for (const auto & d : graph.edges[i].dependencies) {
+            edge.dirty = edge.dirty || edges[d].dirty;
+        }
+        edge.dirty = edge.dirty || is_stale(edge, log, pstate.build_root);
+        if (edge.dirty) {
+            ++dirty;
+        }
+    }
+
+    if (dirty == 0) {
+        std::cout << "meson++: no work to do." << std::endl;
+        return true;
+    }
+
+    std::map<std::string, Pool> pools{};
+    for (const auto & e : edges) {
+        const auto & name = e.rule->pool;
+        if (!name.empty() && pools.find(name) == pools.end()) {
+            pools.emplace(name, Pool{Common::pool_depth(name, pstate.options), 0, {}});
+        }
+    }
+
+    // Like ninja, slightly oversubscribe the CPUs to cover process startup
+    std::size_t njobs = jobs == 0 ? std::thread::hardware_concurrency() + 2 : jobs;
+    njobs = std::min(njobs, dirty);
+
+    Scheduler sched{graph, edges, njobs, pstate.build_root, log, std::move(pools)};
+    return sched.run();
+}
+
+} // namespace Backends::Executor
@@ -0,0 +1,28 @@
+// SPDX-license-identifier: Apache-2.0
+// Copyright © 2021 Intel Corporation
+
+/**
+ * A built in executor, which runs the build without generating a ninja file
+ */
+
+#pragma once
+
+#include "meson/state/state.hpp"
+#include "mir.hpp"
+
+namespace Backends::Executor {
+
+/**
+ * Build all of the targets in a block
+ *
+ * The rules are run directly by a work-stealing pool of threads, one per job,
+ * skipping the generation and parsing of a manifest. Only rules that are out of date,
+ * by the mtimes of their inputs and dependencies or because their command
+ * changed, are run.
+ *
+ * @param jobs The number of rules to run at once, 0 to pick a default
+ * @returns true if the build succeeded
+ */
+bool build(const MIR::BasicBlock * const, const MIR::State::Persistant &, const uint & jobs);
+
+} // namespace Backends::Executor
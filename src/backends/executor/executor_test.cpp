@@ -0,0 +1,93 @@
+// SPDX-license-identifier: Apache-2.0
+// Copyright © 2021 Intel Corporation
+
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+
+#include "build_log.hpp"
+#include "depfile.hpp"
+#include "exceptions.hpp"
+#include "tempdir.hpp"
+
+namespace fs = std::filesystem;
+
+TEST(depfile, simple) {
+    const auto deps = Backends::Executor::parse_depfile("foo.o: foo.cpp foo.hpp\n");
+    ASSERT_EQ(deps, (std::vector<std::string>{"foo.cpp", "foo.hpp"}));
+}
+
+TEST(depfile, continuation) {
+    const auto deps = Backends::Executor::parse_depfile("foo.o: foo.cpp \\\n  /usr/include/stdio.h \\\n bar.hpp\n");
+    ASSERT_EQ(deps, (std::vector<std::string>{"foo.cpp", "/usr/include/stdio.h", "bar.hpp"}));
+}
+
+TEST(depfile, escapes) {
+    const auto deps =
+        Backends::Executor::parse_depfile("a\\ b.o: a\\ b.cpp c$$d.hpp e\\#f.hpp\n");
+    ASSERT_EQ(deps, (std::vector<std::string>{"a b.cpp", "c$d.hpp", "e#f.hpp"}));
+}
+
+TEST(depfile, no_target) {
+    ASSERT_THROW(Backends::Executor::parse_depfile("foo.cpp foo.hpp\n"),
+                 Util::Exceptions::MesonException);
+}
+
+TEST(build_log, round_trip) {
+    const Util::TempDir tmp{"meson++-executor-test"};
+    const auto path = tmp.path() / ".meson++.log";
+    {
+        Backends::Executor::BuildLog log{path};
+        ASSERT_EQ(log.lookup("foo.o"), nullptr);
+        log.record("foo.o", {1, {"foo.cpp", "foo.hpp"}});
+        log.record("bar.o", {2, {}});
+        log.record("foo.o", {3, {"foo.cpp"}});
+    }
+
+    Backends::Executor::BuildLog log{path};
+    const auto * foo = log.lookup("foo.o");
+    ASSERT_NE(foo, nullptr);
+    ASSERT_EQ(foo->command_hash, 3);
+    ASSERT_EQ(foo->deps, std::vector<std::string>{"foo.cpp"});
+    const auto * bar = log.lookup("bar.o");
+    ASSERT_NE(bar, nullptr);
+    ASSERT_EQ(bar->command_hash, 2);
+}
+
+TEST(build_log, truncated) {
+    const Util::TempDir tmp{"meson++-executor-test"};
+    const auto path = tmp.path() / ".meson++.log";
+    {
+        Backends::Executor::BuildLog log{path};
+        log.record("foo.o", {1, {"foo.cpp"}});
+        log.record("bar.o", {2, {"bar.cpp"}});
+    }
+    fs::resize_file(path, fs::file_size(path) - 3);
+
+    // The incomplete record is dropped, but the rest of the log is kept
+    {
+        Backends::Executor::BuildLog log{path};
+        ASSERT_NE(log.lookup("foo.o"), nullptr);
+        ASSERT_EQ(log.lookup("bar.o"), nullptr);
+        log.record("bar.o", {4, {}});
+    }
+
+    Backends::Executor::BuildLog log{path};
+    ASSERT_NE(log.lookup("bar.o"), nullptr);
+    ASSERT_EQ(log.lookup("bar.o")->command_hash, 4);
+}
+
+TEST(build_log, bad_magic) {
+    const Util::TempDir tmp{"meson++-executor-test"};
+    const auto path = tmp.path() / ".meson++.log";
+    std::ofstream{path} << "not a build log";
+
+    Backends::Executor::BuildLog log{path};
+    ASSERT_EQ(log.lookup("foo.o"), nullptr);
+}
+
+TEST(build_log, hash_command) {
+    using Backends::Executor::hash_command;
+    ASSERT_EQ(hash_command({"c++", "-c", "foo.cpp"}), hash_command({"c++", "-c", "foo.cpp"}));
+    ASSERT_NE(hash_command({"c++", "-c", "foo.cpp"}), hash_command({"c++", "-cfoo.cpp"}));
+}
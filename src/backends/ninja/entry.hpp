@@ -7,6 +7,9 @@
 
 #pragma once
 
+#include <filesystem>
+#include <vector>
+
 #include "meson/state/state.hpp"
 #include "mir.hpp"
 
@@ -14,7 +17,10 @@ namespace Backends::Ninja {
 
 /**
  * Generates a ninja file in the build directory
+ *
+ * @returns Every file written into the build directory, relative to it
  */
-void generate(const MIR::BasicBlock * const, const MIR::State::Persistant &);
+std::vector<std::filesystem::path> generate(const MIR::BasicBlock * const,
+                                            const MIR::State::Persistant &);
 
 } // namespace Backends::Ninja
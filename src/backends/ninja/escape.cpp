@@ -0,0 +1,86 @@
+// SPDX-license-identifier: Apache-2.0
+// Copyright © 2021 Intel Corporation
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include "escape.hpp"
+#include "exceptions.hpp"
+
+namespace Backends::Ninja {
+
+namespace {
+
+constexpr uint64_t LOW_BITS = 0x0101010101010101ull;
+constexpr uint64_t HIGH_BITS = 0x8080808080808080ull;
+
+/// Non-zero if any byte of the word is equal to c
+constexpr uint64_t has_byte(const uint64_t word, const unsigned char c) {
+    const uint64_t x = word ^ (LOW_BITS * c);
+    return (x - LOW_BITS) & ~x & HIGH_BITS;
+}
+
+bool is_escapable(const char c, const EscapeMode mode) {
+    switch (mode) {
+        case EscapeMode::PATH:
+            return c == '$' || c == ' ' || c == ':' || c == '|' || c == '\n' || c == '\r';
+        case EscapeMode::VALUE:
+            return c == '$' || c == '\n' || c == '\r';
+    }
+    return false;
+}
+
+bool word_is_escapable(const uint64_t word, const EscapeMode mode) {
+    uint64_t found = has_byte(word, '$') | has_byte(word, '\n') | has_byte(word, '\r');
+    if (mode == EscapeMode::PATH) {
+        found |= has_byte(word, ' ') | has_byte(word, ':') | has_byte(word, '|');
+    }
+    return found != 0;
+}
+
+} // namespace
+
+std::size_t find_escapable(std::string_view str, EscapeMode mode, std::size_t pos) {
+    const char * data = str.data();
+    const std::size_t size = str.size();
+
+    // Skip over whole words that have nothing to escape, the byte at a time
+    // loop then finds the exact position.
+    for (; pos + sizeof(uint64_t) <= size; pos += sizeof(uint64_t)) {
+        uint64_t word;
+        std::memcpy(&word, data + pos, sizeof(word));
+        if (word_is_escapable(word, mode)) {
+            break;
+        }
+    }
+    for (; pos < size; ++pos) {
+        if (is_escapable(data[pos], mode)) {
+            return pos;
+        }
+    }
+    return std::string_view::npos;
+}
+
+void write_escaped(std::ostream & out, std::string_view str, EscapeMode mode) {
+    std::size_t start = 0;
+    std::size_t pos;
+    while ((pos = find_escapable(str, mode, start)) != std::string_view::npos) {
+        if (str[pos] == '\n' || str[pos] == '\r') {
+            throw Util::Exceptions::MesonException{
+                "Ninja does not support newlines in paths or arguments: \"" + std::string{str} +
+                "\""};
+        }
+        // There is no escape for it, it always starts a list of implicit dependencies
+        if (str[pos] == '|') {
+            throw Util::Exceptions::MesonException{"Ninja does not support \"|\" in paths: \"" +
+                                                   std::string{str} + "\""};
+        }
+        out.write(str.data() + start, pos - start);
+        out << '$' << str[pos];
+        start = pos + 1;
+    }
+    out.write(str.data() + start, str.size() - start);
+}
+
+} // namespace Backends::Ninja
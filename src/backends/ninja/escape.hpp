@@ -0,0 +1,45 @@
+// SPDX-license-identifier: Apache-2.0
+// Copyright © 2021 Intel Corporation
+
+/**
+ * Escaping of strings written into ninja files
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <ostream>
+#include <string_view>
+
+namespace Backends::Ninja {
+
+/// Where in a ninja file an escaped string will be written
+enum class EscapeMode {
+    /// Paths in a build statement, where `$`, ` `, and `:` are special, and `|` can't be used
+    PATH,
+    /// Variable values, where only `$` is special
+    VALUE,
+};
+
+/**
+ * Find the first character that needs to be escaped
+ *
+ * This scans a word at a time, as almost all strings have nothing to escape.
+ *
+ * @returns the position of the character, or std::string_view::npos
+ */
+std::size_t find_escapable(std::string_view str, EscapeMode mode, std::size_t pos = 0);
+
+/**
+ * Write a string to a ninja file, escaping it as required
+ *
+ * When there is nothing to escape the string is written as is, without
+ * making a copy.
+ *
+ * @throws Util::Exceptions::MesonException if the string contains a newline
+ *         or carriage return, or a path contains `|`, which ninja has no way
+ *         to represent
+ */
+void write_escaped(std::ostream & out, std::string_view str, EscapeMode mode = EscapeMode::PATH);
+
+} // namespace Backends::Ninja
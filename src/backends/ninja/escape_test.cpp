@@ -0,0 +1,77 @@
+// SPDX-license-identifier: Apache-2.0
+// Copyright © 2021 Intel Corporation
+
+#include <gtest/gtest.h>
+#include <sstream>
+
+#include "escape.hpp"
+#include "exceptions.hpp"
+
+namespace {
+
+std::string escape(const std::string & str,
+                   const Backends::Ninja::EscapeMode mode = Backends::Ninja::EscapeMode::PATH) {
+    std::ostringstream out{};
+    Backends::Ninja::write_escaped(out, str, mode);
+    return out.str();
+}
+
+} // namespace
+
+TEST(ninja_escape, nothing_to_escape) {
+    ASSERT_EQ(escape("src/foo/bar.cpp"), "src/foo/bar.cpp");
+    ASSERT_EQ(escape(""), "");
+}
+
+TEST(ninja_escape, path) {
+    ASSERT_EQ(escape("a b"), "a$ b");
+    ASSERT_EQ(escape("c:/foo"), "c$:/foo");
+    ASSERT_EQ(escape("$foo"), "$$foo");
+    ASSERT_EQ(escape(" :$"), "$ $:$$");
+}
+
+TEST(ninja_escape, value) {
+    ASSERT_EQ(escape("-DFOO=a b:c", Backends::Ninja::EscapeMode::VALUE), "-DFOO=a b:c");
+    ASSERT_EQ(escape("-DFOO=$bar", Backends::Ninja::EscapeMode::VALUE), "-DFOO=$$bar");
+}
+
+TEST(ninja_escape, long_strings) {
+    // Make sure the characters are found at every offset within a word, and
+    // in the tail after the last whole word.
+    const std::string base(37, 'x');
+    for (std::size_t i = 0; i < base.size(); ++i) {
+        std::string in = base;
+        in[i] = ' ';
+        std::string expected = base;
+        expected.replace(i, 1, "$ ");
+        ASSERT_EQ(escape(in), expected) << "at offset " << i;
+        ASSERT_EQ(Backends::Ninja::find_escapable(in, Backends::Ninja::EscapeMode::PATH), i);
+    }
+    ASSERT_EQ(Backends::Ninja::find_escapable(base, Backends::Ninja::EscapeMode::PATH),
+              std::string_view::npos);
+}
+
+TEST(ninja_escape, high_bytes) {
+    // UTF-8 has bytes with the high bit set, which must not be false positives
+    const std::string in = "src/\xc3\xa9\xc3\xa9\xc3\xa9\xc3\xa9\xc3\xa9/\xe2\x82\xac.cpp";
+    ASSERT_EQ(escape(in), in);
+}
+
+TEST(ninja_escape, newline) {
+    ASSERT_THROW(escape("foo\nbar"), Util::Exceptions::MesonException);
+    ASSERT_THROW(escape("foo\nbar", Backends::Ninja::EscapeMode::VALUE),
+                 Util::Exceptions::MesonException);
+}
+
+TEST(ninja_escape, carriage_return) {
+    ASSERT_THROW(escape("foo\rbar"), Util::Exceptions::MesonException);
+    ASSERT_THROW(escape("foo\rbar", Backends::Ninja::EscapeMode::VALUE),
+                 Util::Exceptions::MesonException);
+}
+
+TEST(ninja_escape, pipe) {
+    ASSERT_THROW(escape("foo|bar"), Util::Exceptions::MesonException);
+    // Found in the middle of a word too
+    ASSERT_THROW(escape("src/foo/bar|baz.cpp"), Util::Exceptions::MesonException);
+    ASSERT_EQ(escape("a|b", Backends::Ninja::EscapeMode::VALUE), "a|b");
+}
@@ -0,0 +1,427 @@
+// SPDX-license-identifier: Apache-2.0
+// Copyright © 2021 Intel Corporation
+
+#include <cctype>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <sstream>
+
+#include "escape.hpp"
+#include "exceptions.hpp"
+#include "io.hpp"
+#include "modules.hpp"
+
+namespace fs = std::filesystem;
+
+namespace Backends::Ninja {
+
+namespace {
+
+/**
+ * A parsed JSON value
+ *
+ * This only needs to be good enough to read P1689, so numbers are kept as
+ * their text, and objects keep their order.
+ */
+struct Value {
+    enum class Type {
+        NUL,
+        BOOLEAN,
+        NUMBER,
+        STRING,
+        ARRAY,
+        OBJECT,
+    };
+
+    Type type = Type::NUL;
+
+    /// The value of a string, or the text of a number or boolean
+    std::string string{};
+
+    std::vector<Value> array{};
+
+    std::vector<std::pair<std::string, Value>> object{};
+
+    /// Get a member of an object, or nullptr if it doesn't exist
+    const Value * get(const std::string & key) const {
+        for (const auto & [k, v] : object) {
+            if (k == key) {
+                return &v;
+            }
+        }
+        return nullptr;
+    }
+};
+
+class JSONParser {
+  public:
+    JSONParser(const std::string & s) : str{s}, pos{0} {};
+
+    Value parse() {
+        auto v = value();
+        skip_space();
+        if (pos != str.size()) {
+            error("trailing characters");
+        }
+        return v;
+    }
+
+  private:
+    [[noreturn]] void error(const std::string & msg) const {
+        throw Util::Exceptions::MesonException{"Invalid module dependency file: " + msg +
+                                               " at offset " + std::to_string(pos)};
+    }
+
+    void skip_space() {
+        while (pos < str.size() && std::isspace(static_cast<unsigned char>(str[pos]))) {
+            ++pos;
+        }
+    }
+
+    void expect(const char c) {
+        skip_space();
+        if (pos >= str.size() || str[pos] != c) {
+            error(std::string{"expected '"} + c + "'");
+        }
+        ++pos;
+    }
+
+    bool consume(const char c) {
+        skip_space();
+        if (pos < str.size() && str[pos] == c) {
+            ++pos;
+            return true;
+        }
+        return false;
+    }
+
+    Value value() {
+        skip_space();
+        if (pos >= str.size()) {
+            error("unexpected end of file");
+        }
+
+        Value v{};
+        switch (str[pos]) {
+            case '{':
+                ++pos;
+                v.type = Value::Type::OBJECT;
+                if (!consume('}')) {
+                    do {
+                        skip_space();
+                        auto key = string();
+                        expect(':');
+                        v.object.emplace_back(std::move(key), value());
+                    } while (consume(','));
+                    expect('}');
+                }
+                break;
+            case '[':
+                ++pos;
+                v.type = Value::Type::ARRAY;
+                if (!consume(']')) {
+                    do {
+                        v.array.emplace_back(value());
+                    } while (consume(','));
+                    expect(']');
+                }
+                break;
+            case '"':
+                v.type = Value::Type::STRING;
+                v.string = string();
+                break;
+            default:
+                v = literal();
+        }
+        return v;
+    }
+
+    Value literal() {
+        const auto start = pos;
+        while (pos < str.size() && (std::isalnum(static_cast<unsigned char>(str[pos])) ||
+                                    str[pos] == '-' || str[pos] == '+' || str[pos] == '.')) {
+            ++pos;
+        }
+
+        Value v{};
+        v.string = str.substr(start, pos - start);
+        if (v.string == "null") {
+            v.type = Value::Type::NUL;
+        } else if (v.string == "true" || v.string == "false") {
+            v.type = Value::Type::BOOLEAN;
+        } else if (!v.string.empty() &&
+                   (v.string[0] == '-' || std::isdigit(static_cast<unsigned char>(v.string[0])))) {
+            v.type = Value::Type::NUMBER;
+        } else {
+            pos = start;
+            error("unexpected character");
+        }
+        return v;
+    }
+
+    std::string string() {
+        if (pos >= str.size() || str[pos] != '"') {
+            error("expected a string");
+        }
+        ++pos;
+
+        std::string out{};
+        while (true) {
+            if (pos >= str.size()) {
+                error("unterminated string");
+            }
+            const char c = str[pos++];
+            if (c == '"') {
+                break;
+            } else if (c != '\\') {
+                out.push_back(c);
+                continue;
+            }
+
+            if (pos >= str.size()) {
+                error("unterminated string");
+            }
+            switch (const char e = str[pos++]) {
+                case '"':
+                case '\\':
+                case '/':
+                    out.push_back(e);
+                    break;
+                case 'b':
+                    out.push_back('\b');
+                    break;
+                case 'f':
+                    out.push_back('\f');
+                    break;
+                case 'n':
+                    out.push_back('\n');
+                    break;
+                case 'r':
+                    out.push_back('\r');
+                    break;
+                case 't':
+                    out.push_back('\t');
+                    break;
+                case 'u':
+                    append_utf8(codepoint(), out);
+                    break;
+                default:
+                    error("invalid escape");
+            }
+        }
+        return out;
+    }
+
+    uint32_t hex4() {
+        if (pos + 4 > str.size()) {
+            error("truncated unicode escape");
+        }
+        uint32_t v = 0;
+        for (int i = 0; i < 4; ++i) {
+            const char c = str[pos++];
+            v <<= 4;
+            if (c >= '0' && c <= '9') {
+                v |= c - '0';
+            } else if (c >= 'a' && c <= 'f') {
+                v |= c - 'a' + 10;
+            } else if (c >= 'A' && c <= 'F') {
+                v |= c - 'A' + 10;
+            } else {
+                error("invalid unicode escape");
+            }
+        }
+        return v;
+    }
+
+    uint32_t codepoint() {
+        const auto high = hex4();
+        if (high < 0xd800 || high > 0xdbff) {
+            return high;
+        }
+        // A surrogate pair
+        if (pos + 2 > str.size() || str[pos] != '\\' || str[pos + 1] != 'u') {
+            error("unpaired surrogate");
+        }
+        pos += 2;
+        const auto low = hex4();
+        if (low < 0xdc00 || low > 0xdfff) {
+            error("unpaired surrogate");
+        }
+        return 0x10000 + ((high - 0xd800) << 10) + (low - 0xdc00);
+    }
+
+    static void append_utf8(const uint32_t c, std::string & out) {
+        if (c < 0x80) {
+            out.push_back(static_cast<char>(c));
+        } else if (c < 0x800) {
+            out.push_back(static_cast<char>(0xc0 | (c >> 6)));
+            out.push_back(static_cast<char>(0x80 | (c & 0x3f)));
+        } else if (c < 0x10000) {
+            out.push_back(static_cast<char>(0xe0 | (c >> 12)));
+            out.push_back(static_cast<char>(0x80 | ((c >> 6) & 0x3f)));
+            out.push_back(static_cast<char>(0x80 | (c & 0x3f)));
+        } else {
+            out.push_back(static_cast<char>(0xf0 | (c >> 18)));
+            out.push_back(static_cast<char>(0x80 | ((c >> 12) & 0x3f)));
+            out.push_back(static_cast<char>(0x80 | ((c >> 6) & 0x3f)));
+            out.push_back(static_cast<char>(0x80 | (c & 0x3f)));
+        }
+    }
+
+    const std::string & str;
+    std::size_t pos;
+};
+
+/// Get the logical names from a list of P1689 module descriptions
+std::vector<std::string> logical_names(const Value * list) {
+    std::vector<std::string> names{};
+    if (list == nullptr) {
+        return names;
+    }
+    if (list->type != Value::Type::ARRAY) {
+        throw Util::Exceptions::MesonException{
+            "Invalid module dependency file: expected a list of modules"};
+    }
+    for (const auto & m : list->array) {
+        const auto name = m.get("logical-name");
+        if (name == nullptr || name->type != Value::Type::STRING) {
+            throw Util::Exceptions::MesonException{
+                "Invalid module dependency file: module without a logical-name"};
+        }
+        names.emplace_back(name->string);
+    }
+    return names;
+}
+
+/// Where the compiled interface of a module is written
+std::string interface_path(const std::string & format, const fs::path & dir,
+                           const std::string & module, const std::string & object) {
+    if (format == "gcc") {
+        // Partitions are named `mod:part`, which isn't friendly to ninja or make
+        std::string name = module;
+        for (auto & c : name) {
+            if (c == ':') {
+                c = '-';
+            }
+        }
+        return (dir / (name + ".gcm")).string();
+    } else if (format == "clang") {
+        // Clang writes the interface next to the object, as requested with
+        // a bare -fmodule-output
+        return fs::path{object}.replace_extension(".pcm").string();
+    }
+    throw Util::Exceptions::MesonException{"C++ modules are not supported with the " + format +
+                                           " compiler"};
+}
+
+std::string read_file(const fs::path & path) {
+    std::ifstream in{path, std::ios::binary};
+    if (!in.is_open()) {
+        throw Util::Exceptions::MesonException{"Could not read module dependency file " +
+                                               path.string()};
+    }
+    return std::string{std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{}};
+}
+
+} // namespace
+
+std::vector<ModuleUnit> parse_p1689(const std::string & contents) {
+    const auto root = JSONParser{contents}.parse();
+    const auto rules = root.get("rules");
+    if (root.type != Value::Type::OBJECT || rules == nullptr ||
+        rules->type != Value::Type::ARRAY) {
+        throw Util::Exceptions::MesonException{
+            "Invalid module dependency file: expected an object with a list of rules"};
+    }
+
+    std::vector<ModuleUnit> units{};
+    for (const auto & r : rules->array) {
+        const auto out = r.get("primary-output");
+        if (out == nullptr || out->type != Value::Type::STRING) {
+            throw Util::Exceptions::MesonException{
+                "Invalid module dependency file: rule without a primary-output"};
+        }
+        units.emplace_back(ModuleUnit{out->string, logical_names(r.get("provides")),
+                                      logical_names(r.get("requires"))});
+    }
+    return units;
+}
+
+ModuleFiles collate_modules(const std::string & format, const fs::path & dir,
+                            const std::vector<ModuleUnit> & units) {
+    // module name : compiled interface, ordered so that the map is stable
+    std::map<std::string, std::string> interfaces{};
+    std::map<std::string, const std::string *> providers{};
+    for (const auto & u : units) {
+        for (const auto & m : u.provides) {
+            auto && [it, inserted] = providers.emplace(m, &u.object);
+            if (!inserted) {
+                throw Util::Exceptions::MesonException{"Module \"" + m + "\" is provided by both " +
+                                                       *it->second + " and " + u.object};
+            }
+            interfaces.emplace(m, interface_path(format, dir, m, u.object));
+        }
+    }
+
+    // Every edge using the dyndep file must be listed, even if it doesn't
+    // use any modules.
+    std::ostringstream dyndep{};
+    dyndep << "ninja_dyndep_version = 1\n\n";
+    for (const auto & u : units) {
+        dyndep << "build ";
+        write_escaped(dyndep, u.object);
+        if (!u.provides.empty()) {
+            dyndep << " |";
+            for (const auto & m : u.provides) {
+                dyndep << " ";
+                write_escaped(dyndep, interfaces.at(m));
+            }
+        }
+        dyndep << ": dyndep";
+
+        bool first = true;
+        for (const auto & m : u.imports) {
+            const auto it = interfaces.find(m);
+            if (it == interfaces.end()) {
+                continue;
+            }
+            dyndep << (first ? " | " : " ");
+            first = false;
+            write_escaped(dyndep, it->second);
+        }
+        dyndep << "\n  restat = 1\n\n";
+    }
+
+    std::ostringstream map{};
+    if (format == "gcc") {
+        // Interface paths are relative to the root, which otherwise defaults to gcm.cache
+        map << "$root .\n";
+    }
+    for (const auto & [m, path] : interfaces) {
+        if (format == "gcc") {
+            map << m << " " << path << "\n";
+        } else {
+            map << "-fmodule-file=" << m << "=" << path << "\n";
+        }
+    }
+
+    return ModuleFiles{dyndep.str(), map.str()};
+}
+
+void write_module_files(const std::string & format, const fs::path & map,
+                        const fs::path & dyndep, const std::vector<fs::path> & ddis) {
+    std::vector<ModuleUnit> units{};
+    for (const auto & d : ddis) {
+        for (auto && u : parse_p1689(read_file(d))) {
+            units.emplace_back(std::move(u));
+        }
+    }
+
+    const auto files = collate_modules(format, dyndep.parent_path(), units);
+    Util::write_if_changed(map, files.map);
+    Util::write_if_changed(dyndep, files.dyndep);
+}
+
+} // namespace Backends::Ninja
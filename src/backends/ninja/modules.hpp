@@ -0,0 +1,75 @@
+// SPDX-license-identifier: Apache-2.0
+// Copyright © 2021 Intel Corporation
+
+/**
+ * C++ module dependency collation
+ *
+ * Each source is scanned by the compiler, which writes the modules it
+ * provides and requires in the P1689 format. Those are combined per target
+ * into a ninja dyndep file, which orders the compiles, and a map from module
+ * names to compiled interfaces which the compiler reads.
+ */
+
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace Backends::Ninja {
+
+/// The modules provided and required by a single translation unit
+struct ModuleUnit {
+    /// The object the unit is compiled into
+    std::string object;
+
+    /// Logical names of the modules this unit provides
+    std::vector<std::string> provides;
+
+    /// Logical names of the modules this unit imports
+    std::vector<std::string> imports;
+};
+
+/// The files written for a target's modules
+struct ModuleFiles {
+    /// The contents of the ninja dyndep file
+    std::string dyndep;
+
+    /// The contents of the module map read by the compiler
+    std::string map;
+};
+
+/**
+ * Read the translation units from a P1689 module dependency file
+ *
+ * @throws Util::Exceptions::MesonException if the contents are not valid P1689
+ */
+std::vector<ModuleUnit> parse_p1689(const std::string & contents);
+
+/**
+ * Combine the scan results of a target
+ *
+ * Imports of modules not provided by the target, such as `import std;`, are
+ * left for the compiler to resolve.
+ *
+ * @param format The id of the compiler, which decides the format of the map
+ *               and where compiled interfaces are written
+ * @param dir The target's private directory
+ * @param units Every translation unit in the target
+ * @throws Util::Exceptions::MesonException if a module is provided twice, or
+ *         the compiler isn't supported
+ */
+ModuleFiles collate_modules(const std::string & format, const std::filesystem::path & dir,
+                            const std::vector<ModuleUnit> & units);
+
+/**
+ * Read the scan results of a target, and write its dyndep file and module map
+ *
+ * Each file is only written if it changed, so that an edit that doesn't
+ * change any imports doesn't cause a rebuild of everything.
+ */
+void write_module_files(const std::string & format, const std::filesystem::path & map,
+                        const std::filesystem::path & dyndep,
+                        const std::vector<std::filesystem::path> & ddis);
+
+} // namespace Backends::Ninja
@@ -0,0 +1,113 @@
+// SPDX-license-identifier: Apache-2.0
+// Copyright © 2021 Intel Corporation
+
+#include <gtest/gtest.h>
+
+#include "exceptions.hpp"
+#include "modules.hpp"
+
+namespace {
+
+// Roughly what GCC writes for a module interface that imports a partition
+const std::string INTERFACE = R"EOF({
+"rules": [
+{
+"primary-output": "prog.p/foo.cpp.o",
+"provides": [
+{
+"logical-name": "foo",
+"is-interface": true
+}
+],
+"requires": [
+{
+"logical-name": "foo:bar"
+},
+{
+"logical-name": "std"
+}
+]
+}
+],
+"version": 0,
+"revision": 0
+}
+)EOF";
+
+} // namespace
+
+TEST(p1689, parse) {
+    const auto units = Backends::Ninja::parse_p1689(INTERFACE);
+    ASSERT_EQ(units.size(), 1);
+    ASSERT_EQ(units[0].object, "prog.p/foo.cpp.o");
+    ASSERT_EQ(units[0].provides, std::vector<std::string>{"foo"});
+    const std::vector<std::string> imports{"foo:bar", "std"};
+    ASSERT_EQ(units[0].imports, imports);
+}
+
+TEST(p1689, no_modules) {
+    const auto units = Backends::Ninja::parse_p1689(
+        R"({"rules": [{"primary-output": "a b.o"}], "version": 0, "revision": 0})");
+    ASSERT_EQ(units.size(), 1);
+    ASSERT_EQ(units[0].object, "a b.o");
+    ASSERT_TRUE(units[0].provides.empty());
+    ASSERT_TRUE(units[0].imports.empty());
+}
+
+TEST(p1689, string_escapes) {
+    const auto units = Backends::Ninja::parse_p1689(
+        R"({"rules": [{"primary-output": "a\"\\\u00e9\ud83d\ude00.o"}]})");
+    ASSERT_EQ(units[0].object, "a\"\\\xc3\xa9\xf0\x9f\x98\x80.o");
+}
+
+TEST(p1689, invalid) {
+    ASSERT_THROW(Backends::Ninja::parse_p1689(""), Util::Exceptions::MesonException);
+    ASSERT_THROW(Backends::Ninja::parse_p1689("{\"rules\": [}"),
+                 Util::Exceptions::MesonException);
+    ASSERT_THROW(Backends::Ninja::parse_p1689("{\"rules\": [{}]}"),
+                 Util::Exceptions::MesonException);
+    ASSERT_THROW(Backends::Ninja::parse_p1689("[]"), Util::Exceptions::MesonException);
+}
+
+TEST(collate_modules, gcc) {
+    const std::vector<Backends::Ninja::ModuleUnit> units{
+        {"prog.p/foo.cpp.o", {"foo"}, {"foo:bar", "std"}},
+        {"prog.p/bar.cpp.o", {"foo:bar"}, {}},
+        {"prog.p/main.cpp.o", {}, {"foo"}},
+    };
+    const auto files = Backends::Ninja::collate_modules("gcc", "prog.p", units);
+
+    ASSERT_EQ(files.dyndep, "ninja_dyndep_version = 1\n"
+                            "\n"
+                            "build prog.p/foo.cpp.o | prog.p/foo.gcm: dyndep | prog.p/foo-bar.gcm\n"
+                            "  restat = 1\n"
+                            "\n"
+                            "build prog.p/bar.cpp.o | prog.p/foo-bar.gcm: dyndep\n"
+                            "  restat = 1\n"
+                            "\n"
+                            "build prog.p/main.cpp.o: dyndep | prog.p/foo.gcm\n"
+                            "  restat = 1\n"
+                            "\n");
+    ASSERT_EQ(files.map, "$root .\n"
+                         "foo prog.p/foo.gcm\n"
+                         "foo:bar prog.p/foo-bar.gcm\n");
+}
+
+TEST(collate_modules, clang) {
+    const std::vector<Backends::Ninja::ModuleUnit> units{
+        {"prog.p/foo.cpp.o", {"foo"}, {}},
+        {"prog.p/main.cpp.o", {}, {"foo"}},
+    };
+    const auto files = Backends::Ninja::collate_modules("clang", "prog.p", units);
+
+    ASSERT_EQ(files.map, "-fmodule-file=foo=prog.p/foo.cpp.pcm\n");
+}
+
+TEST(collate_modules, duplicate) {
+    const std::vector<Backends::Ninja::ModuleUnit> units{
+        {"prog.p/a.cpp.o", {"foo"}, {}},
+        {"prog.p/b.cpp.o", {"foo"}, {}},
+    };
+    ASSERT_THROW(Backends::Ninja::collate_modules("gcc", "prog.p", units),
+                 Util::Exceptions::MesonException);
+}
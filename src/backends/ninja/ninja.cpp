@@ -5,16 +5,26 @@
  * Main ninja backend entry point.
  */
 
-#include <algorithm>
 #include <cerrno>
 #include <filesystem>
-#include <fstream>
+#include <iomanip>
+#include <map>
+#include <set>
+#include <sstream>
 #include <sys/stat.h>
+#include <unordered_map>
 #include <variant>
 #include <vector>
 
+#include "common/graph.hpp"
+#include "common/rules.hpp"
+#include "common/target_cache.hpp"
 #include "entry.hpp"
+#include "escape.hpp"
 #include "exceptions.hpp"
+#include "hash.hpp"
+#include "io.hpp"
+#include "threads.hpp"
 #include "toolchains/compiler.hpp"
 
 namespace fs = std::filesystem;
@@ -23,21 +33,39 @@ namespace Backends::Ninja {
 
 namespace {
 
+using Common::Rule;
+using Common::RuleType;
+using Common::TargetRules;
+
+/// The cache of rendered targets, so that unchanged targets can be reused
+const std::string TARGET_CACHE = ".meson++.targets";
+
 void write_compiler_rule(const std::string & lang,
                          const std::unique_ptr<MIR::Toolchain::Compiler::Compiler> & c,
-                         std::ofstream & out) {
+                         const bool pch, std::ostream & out) {
 
     // TODO: build or host correctly
-    out << "rule " << lang << "_compiler_for_"
+    out << "rule " << lang << (pch ? "_pch" : "") << "_compiler_for_"
         << "build" << std::endl;
 
     // Write the command
-    // TODO: write the depfile stuff
     out << "  command =";
+    // The launcher (ccache, etc) only wraps compilation, never linking
+    for (const auto & c : c->launcher) {
+        out << " " << c;
+    }
     for (const auto & c : c->command) {
         out << " " << c;
     }
     out << " ${ARGS}";
+    for (const auto & c : c->generate_depfile("${out}", "${out}.d")) {
+        out << " " << c;
+    }
+    if (pch) {
+        for (const auto & c : c->precompile_header_command()) {
+            out << " " << c;
+        }
+    }
     for (const auto & c : c->output_command("${out}")) {
         out << " " << c;
     }
@@ -46,38 +74,95 @@ void write_compiler_rule(const std::string & lang,
     }
     out << " ${in}" << std::endl;
 
+    // Have ninja read the depfile into its deps log, so that it doesn't have
+    // to re-parse the depfiles on every invocation.
+    out << "  depfile = ${out}.d" << std::endl << "  deps = gcc" << std::endl;
+
     // Write the description
-    out << "  description = Compiling " << c->language() << " object ${out}" << std::endl
+    if (pch) {
+        out << "  description = Precompiling " << c->language() << " header ${out}" << std::endl
+            << std::endl;
+    } else {
+        out << "  description = Compiling " << c->language() << " object ${out}" << std::endl
+            << std::endl;
+    }
+}
+
+void write_scan_rule(const std::string & lang,
+                     const std::unique_ptr<MIR::Toolchain::Compiler::Compiler> & c,
+                     std::ostream & out) {
+
+    // TODO: build or host correctly
+    out << "rule " << lang << "_scan_for_build\n";
+
+    // The module specific arguments, including the object name, are part of ${ARGS}
+    out << "  command =";
+    for (const auto & c : c->module_scan_wrapper("${out}")) {
+        out << " " << c;
+    }
+    for (const auto & c : c->command) {
+        out << " " << c;
+    }
+    out << " ${ARGS}";
+    for (const auto & c : c->generate_depfile("${out}", "${out}.d")) {
+        out << " " << c;
+    }
+    out << " ${in}\n";
+
+    out << "  depfile = ${out}.d\n"
+        << "  deps = gcc\n"
+        << "  description = Scanning " << c->language() << " source ${in} for modules\n"
+        << std::endl;
+}
+
+void write_collate_rule(const std::string & lang, const MIR::State::Persistant & pstate,
+                        std::ostream & out) {
+
+    // TODO: build or host correctly
+    out << "rule " << lang << "_collate_for_build\n";
+
+    out << "  command = ";
+    write_escaped(out, pstate.program.string(), EscapeMode::VALUE);
+    out << " internal collate-modules ${ARGS} ${out} ${in}\n";
+
+    // Nothing needs to be rebuilt if the imports didn't change
+    out << "  description = Collating module dependencies ${out}\n"
+        << "  restat = 1\n"
         << std::endl;
 }
 
 void write_archiver_rule(const std::string & lang,
                          const std::unique_ptr<MIR::Toolchain::Archiver::Archiver> & c,
-                         std::ofstream & out) {
+                         const bool rsp, std::ostream & out) {
 
     // TODO: build or host correctly
-    out << "rule " << lang << "_archiver_for_"
+    out << "rule " << lang << "_archiver" << (rsp ? "_rsp" : "") << "_for_"
         << "build" << std::endl;
 
     // Write the command
     // TODO: write the depfile stuff
-    out << "  command =";
-    out << "rm -f ${out} &&";
+    out << "  command = rm -f ${out} &&";
     for (const auto & c : c->command()) {
         out << " " << c;
     }
-    out << " ${ARGS} ${out} ${in}\n";
+    if (rsp) {
+        out << " ${ARGS} ${out} @${out}.rsp\n";
+        out << "  rspfile = ${out}.rsp\n"
+            << "  rspfile_content = ${in}\n";
+    } else {
+        out << " ${ARGS} ${out} ${in}\n";
+    }
 
     // Write the description
     out << "  description = Linking Static target ${out}\n" << std::endl;
 }
 
 void write_linker_rule(const std::string & lang,
-                       const std::unique_ptr<MIR::Toolchain::Linker::Linker> & c,
-                       std::ofstream & out) {
+                       const std::unique_ptr<MIR::Toolchain::Linker::Linker> & c, const bool rsp,
+                       std::ostream & out) {
 
     // TODO: build or host correctly
-    out << "rule " << lang << "_linker_for_"
+    out << "rule " << lang << "_linker" << (rsp ? "_rsp" : "") << "_for_"
         << "build" << std::endl;
 
     // Write the command
@@ -86,196 +171,305 @@ void write_linker_rule(const std::string & lang,
     for (const auto & c : c->command()) {
         out << " " << c;
     }
-    out << " ${ARGS}";
+    // The response file takes the arguments too, they are what makes the command long
+    if (!rsp) {
+        out << " ${ARGS}";
+    }
     for (const auto & c : c->output_command("${out}")) {
         out << " " << c;
     }
-    out << " ${in} ${ARGS}" << std::endl;
+    if (rsp) {
+        out << " @${out}.rsp" << std::endl;
+        out << "  rspfile = ${out}.rsp" << std::endl
+            << "  rspfile_content = ${in} ${ARGS}" << std::endl;
+    } else {
+        out << " ${in} ${ARGS}" << std::endl;
+    }
 
     // Write the description
     out << "  description = Linking target ${out}" << std::endl << std::endl;
 }
 
-std::string escape(const std::string & str) {
-    std::string new_s{};
-    for (const auto & s : str) {
-        if (s == ' ') {
-            new_s.push_back('$');
-            new_s.push_back(s);
+/**
+ * Quote an argument for the shell ninja runs commands with, if needed
+ */
+std::string shell_quote(const std::string & arg) {
+    if (!arg.empty() && arg.find_first_not_of("abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ"
+                                              "0123456789_-+=/.,:@%") == std::string::npos) {
+        return arg;
+    }
+    std::string quoted{"'"};
+    for (const auto & c : arg) {
+        if (c == '\'') {
+            quoted += "'\\''";
         } else {
-            new_s.push_back(s);
+            quoted += c;
         }
     }
-    return new_s;
+    return quoted + "'";
 }
 
-enum class RuleType {
-    COMPILE,
-    ARCHIVE,
-    LINK,
-};
-
 /**
- * A Ninja rule to be generated later
+ * Write the rule and edge that rerun meson++ when a build definition changes
+ *
+ * The edge depends on exactly the files the frontend read. It is a generator
+ * so that cleaning doesn't remove build.ninja, and restat is set so that a
+ * regeneration which leaves the outputs unchanged doesn't cause everything
+ * depending on them to be rebuilt.
  */
-class Rule {
-  public:
-    Rule(const std::vector<std::string> & in, const std::string & out, const RuleType & r,
-         const MIR::Toolchain::Language & l, const MIR::Machines::Machine & m)
-        : input{in}, output{out}, type{r}, lang{l}, machine{m}, arguments{} {};
-    Rule(const std::vector<std::string> & in, const std::string & out, const RuleType & r,
-         const MIR::Toolchain::Language & l, const MIR::Machines::Machine & m,
-         const std::vector<std::string> & args)
-        : input{in}, output{out}, type{r}, lang{l}, machine{m}, arguments{args} {};
+void write_regenerate_rule(const MIR::State::Persistant & pstate, std::ostream & out) {
+    std::vector<std::string> command{pstate.program.string(), "configure", "-s",
+                                     fs::absolute(pstate.source_root).lexically_normal().string()};
+    for (const auto & [k, v] : pstate.cmdline_options) {
+        command.emplace_back("-D" + k + "=" + v);
+    }
+    command.emplace_back(fs::absolute(pstate.build_root).lexically_normal().string());
 
-    /// The input for this rule
-    const std::vector<std::string> input;
+    out << "rule REGENERATE_BUILD\n"
+        << "  command =";
+    for (const auto & c : command) {
+        out << " ";
+        write_escaped(out, shell_quote(c), EscapeMode::VALUE);
+    }
+    out << "\n"
+        << "  description = Regenerating build files\n"
+        << "  generator = 1\n"
+        << "  restat = 1\n"
+        << "  pool = console\n"
+        << std::endl;
 
-    /// The output of this rule
-    const std::string output;
+    out << "build build.ninja | compile_commands.json: REGENERATE_BUILD";
+    for (const auto & f : pstate.build_files) {
+        out << " ";
+        write_escaped(out, fs::relative(f, pstate.build_root).string());
+    }
+    out << "\n\n";
+}
 
-    /// The type of rule this is
-    const RuleType type;
+/**
+ * Deduplicates the argument lists of compile rules
+ *
+ * Every source in a target gets the same arguments, so rather than writing
+ * them out on every edge each unique list is written once as a top level
+ * variable, and the edges refer to that.
+ *
+ * Variables are named by a hash of their arguments rather than by position,
+ * so that edges rendered in a previous configure still refer to the right one.
+ */
+class ArgumentTable {
+  public:
+    ArgumentTable() : names{}, used{}, order{} {};
+
+    /// Get the variable holding these arguments, adding it if it doesn't exist yet
+    const std::string & intern(const MIR::Toolchain::Language & l,
+                               const std::vector<std::string> & args) {
+        auto && [it, inserted] = names.try_emplace(Key{l, args}, "");
+        if (inserted) {
+            std::ostringstream name{};
+            name << MIR::Toolchain::to_string(l) << "_args_" << std::hex << std::setw(16)
+                 << std::setfill('0') << Util::Hasher{}.add(args).digest();
+            it->second = name.str();
+            if (!used.emplace(it->second).second) {
+                throw Util::Exceptions::MesonException{"Hash collision between argument lists " +
+                                                       it->second};
+            }
+            order.emplace_back(&*it);
+        }
+        return it->second;
+    }
 
-    /// The language of this rule
-    const MIR::Toolchain::Language lang;
+    /// Write all of the variables, in the order they were added
+    void write(std::ostream & out) const {
+        for (const auto & v : order) {
+            out << v->second << " =";
+            for (const auto & a : v->first.second) {
+                out << " ";
+                write_escaped(out, a, EscapeMode::VALUE);
+            }
+            out << "\n";
+        }
+        out << std::endl;
+    }
 
-    /// The machine of this rule
-    const MIR::Machines::Machine machine;
+  private:
+    using Key = std::pair<MIR::Toolchain::Language, std::vector<std::string>>;
 
-    /// The arguments for this rule
-    const std::vector<std::string> arguments;
+    std::map<Key, std::string> names;
+    std::set<std::string> used;
+    std::vector<const std::pair<const Key, std::string> *> order;
 };
 
-void write_build_rule(const Rule & rule, std::ofstream & out) {
+void write_build_rule(const Rule & rule, const std::string & args_var,
+                      const MIR::State::Persistant & pstate, std::ostream & out) {
     // TODO: get the actual compiler/linker
+    const auto & tc = pstate.toolchains.at(rule.lang).get(rule.machine);
+
     std::string rule_name;
     switch (rule.type) {
         case RuleType::COMPILE:
             rule_name = "cpp_compiler_for_build";
             break;
+        case RuleType::PCH:
+            rule_name = "cpp_pch_compiler_for_build";
+            break;
+        case RuleType::SCAN:
+            rule_name = "cpp_scan_for_build";
+            break;
+        case RuleType::COLLATE:
+            rule_name = "cpp_collate_for_build";
+            break;
         case RuleType::LINK:
-            rule_name = "cpp_linker_for_build";
+            if (tc->linker->rsp_support() == MIR::Toolchain::RSPFileSupport::GCC &&
+                Common::needs_rsp(rule)) {
+                rule_name = "cpp_linker_rsp_for_build";
+            } else {
+                rule_name = "cpp_linker_for_build";
+            }
             break;
         case RuleType::ARCHIVE: // TODO:
-            rule_name = "cpp_archiver_for_build";
+            if (tc->archiver->rsp_support() == MIR::Toolchain::RSPFileSupport::GCC &&
+                Common::needs_rsp(rule)) {
+                rule_name = "cpp_archiver_rsp_for_build";
+            } else {
+                rule_name = "cpp_archiver_for_build";
+            }
             break;
         default:
             throw std::exception{}; // should be unreachable
     }
 
-    out << "build " << rule.output << ": " << rule_name;
+    out << "build ";
+    write_escaped(out, rule.output);
+    if (!rule.implicit_output.empty()) {
+        out << " |";
+        for (const auto & o : rule.implicit_output) {
+            out << " ";
+            write_escaped(out, o);
+        }
+    }
+    out << ": " << rule_name;
     for (const auto & o : rule.input) {
-        out << " " << o;
+        out << " ";
+        write_escaped(out, o);
     }
-    out << "\n";
-
-    out << "  ARGS =";
-    for (const auto & a : rule.arguments) {
-        out << " " << a;
+    if (!rule.implicit_input.empty()) {
+        out << " |";
+        for (const auto & o : rule.implicit_input) {
+            out << " ";
+            write_escaped(out, o);
+        }
     }
-    out << "\n" << std::endl;
-}
+    out << "\n";
 
-template <typename T>
-std::vector<Rule> target_rule(const T & e, const MIR::State::Persistant & pstate) {
-    static_assert(std::is_base_of<MIR::Objects::Executable, T>::value ||
-                      std::is_base_of<MIR::Objects::StaticLibrary, T>::value,
-                  "Must be derived from a build target");
-
-    std::vector<std::string> cpp_args{};
-    if (e.arguments.find(MIR::Toolchain::Language::CPP) != e.arguments.end()) {
-        const auto & tc = pstate.toolchains.at(MIR::Toolchain::Language::CPP);
-        for (const auto & a : e.arguments.at(MIR::Toolchain::Language::CPP)) {
-            cpp_args.emplace_back(tc.build()->compiler->specialize_argument(a));
+    if (!args_var.empty()) {
+        out << "  ARGS = $" << args_var << "\n";
+    } else {
+        out << "  ARGS =";
+        for (const auto & a : rule.arguments) {
+            out << " ";
+            write_escaped(out, a, EscapeMode::VALUE);
         }
+        out << "\n";
     }
 
-    std::vector<Rule> rules{};
-    const auto & tc = pstate.toolchains.at(MIR::Toolchain::Language::CPP);
-
-    std::vector<std::string> srcs{};
-    for (const auto & f : e.sources) {
-        // TODO: obj files are a per compiler thing, I think
-        // TODO: get the proper language
-        // TODO: actually set args to something
-        // TODO: do something better for private dirs, we really need the subdir for this
-
-        auto lang_args = cpp_args;
-        auto always_args = tc.build()->compiler->always_args();
-        lang_args.insert(lang_args.end(), always_args.begin(), always_args.end());
-
-        rules.emplace_back(Rule{{escape(f.relative_to_build_dir())},
-                                escape(fs::path{e.name + ".p"} / f.get_name()) + ".o",
-                                RuleType::COMPILE,
-                                MIR::Toolchain::Language::CPP,
-                                MIR::Machines::Machine::BUILD,
-                                lang_args});
+    if (!rule.pool.empty()) {
+        out << "  pool = " << rule.pool << "\n";
     }
-
-    std::vector<std::string> final_outs;
-    for (const auto & r : rules) {
-        final_outs.emplace_back(r.output);
+    if (!rule.dyndep.empty()) {
+        out << "  dyndep = ";
+        write_escaped(out, rule.dyndep, EscapeMode::VALUE);
+        out << "\n";
     }
+    out << std::endl;
+}
 
-    std::string name;
-    RuleType type;
-    std::vector<std::string> link_args{};
-    if constexpr (std::is_base_of<MIR::Objects::StaticLibrary, T>::value) {
-        type = RuleType::ARCHIVE;
-        // TODO: per platform?
-        name = e.name + ".a";
-        // TODO: need to combin with link_arguments from DSL
-        link_args = tc.build()->archiver->always_args();
-    } else {
-        type = RuleType::LINK;
-        name = e.name;
-        link_args = tc.build()->linker->always_args();
-    }
+/**
+ * Write a compile_commands.json for all of the compile rules
+ *
+ * This is streamed straight out of the rule list, using the "arguments" form
+ * so that no shell quoting is required.
+ */
+void write_compdb(const std::vector<TargetRules> & targets,
+                  const MIR::State::Persistant & pstate) {
+    std::ostringstream out{};
+    const auto & dir = fs::absolute(pstate.build_root).lexically_normal().string();
+
+    out << "[";
+    bool first = true;
+    for (const auto & rules : targets) {
+        for (const auto & r : rules) {
+            if (r.type != RuleType::COMPILE) {
+                continue;
+            }
+            const auto & c = pstate.toolchains.at(r.lang).get(r.machine)->compiler;
+
+            out << (first ? "\n" : ",\n") << "  {\n    \"directory\": ";
+            first = false;
+            Util::write_json_string(dir, out);
+            out << ",\n    \"arguments\": [";
+
+            // Tools reading the database want the real compiler, not the launcher
+            std::vector<std::string> args = c->command;
+            args.insert(args.end(), r.arguments.begin(), r.arguments.end());
+            for (auto && a : c->output_command(r.output)) {
+                args.emplace_back(std::move(a));
+            }
+            for (auto && a : c->compile_only_command()) {
+                args.emplace_back(std::move(a));
+            }
+            args.insert(args.end(), r.input.begin(), r.input.end());
 
-    // TODO: linker/archiver always_args
+            for (auto it = args.begin(); it != args.end(); ++it) {
+                if (it != args.begin()) {
+                    out << ", ";
+                }
+                Util::write_json_string(*it, out);
+            }
 
-    rules.emplace_back(Rule{
-        final_outs,
-        name,
-        type,
-        MIR::Toolchain::Language::CPP,
-        MIR::Machines::Machine::BUILD,
-        link_args,
-    });
+            out << "],\n    \"file\": ";
+            Util::write_json_string(r.input.front(), out);
+            out << ",\n    \"output\": ";
+            Util::write_json_string(r.output, out);
+            out << "\n  }";
+        }
+    }
+    out << "\n]\n";
 
-    return rules;
+    Util::write_if_changed(pstate.build_root / "compile_commands.json", out.str());
 }
 
-std::vector<Rule> mir_to_rules(const MIR::BasicBlock * const block,
-                               const MIR::State::Persistant & pstate) {
-    // A list of all rules
-    std::vector<Rule> rules{};
-
-    // A mapping of named targets to their rules.
-    std::unordered_map<std::string, const Rule * const> rule_map{};
-
-    for (const auto & i : block->instructions) {
-        if (const auto x = std::get_if<std::unique_ptr<MIR::Executable>>(&i); x != nullptr) {
-            auto r = target_rule((*x)->value, pstate);
-            std::move(r.begin(), r.end(), std::back_inserter(rules));
-            const Rule * const named_rule = &rules.back();
-            rule_map.emplace(named_rule->output, named_rule);
-        }
-        if (std::holds_alternative<std::unique_ptr<MIR::StaticLibrary>>(i)) {
-            auto r = target_rule(std::get<std::unique_ptr<MIR::StaticLibrary>>(i)->value, pstate);
-            std::move(r.begin(), r.end(), std::back_inserter(rules));
-            const Rule * const named_rule = &rules.back();
-            rule_map.emplace(named_rule->output, named_rule);
+/**
+ * Find the sources that configure wrote into the build directory, like unity files
+ *
+ * These are inputs inside of the build directory which no rule creates.
+ */
+std::vector<fs::path> generated_sources(const std::vector<TargetRules> & rules) {
+    std::set<std::string> outputs{};
+    for (const auto & target : rules) {
+        for (const auto & r : target) {
+            outputs.emplace(r.output);
+            outputs.insert(r.implicit_output.begin(), r.implicit_output.end());
         }
     }
 
-    return rules;
+    std::set<fs::path> sources{};
+    for (const auto & target : rules) {
+        for (const auto & r : target) {
+            for (const auto & i : r.input) {
+                const fs::path p{i};
+                if (p.is_relative() && *p.begin() != ".." && outputs.count(i) == 0) {
+                    sources.emplace(p);
+                }
+            }
+        }
+    }
+    return {sources.begin(), sources.end()};
 }
 
 } // namespace
 
-void generate(const MIR::BasicBlock * const block, const MIR::State::Persistant & pstate) {
+std::vector<fs::path> generate(const MIR::BasicBlock * const block,
+                               const MIR::State::Persistant & pstate) {
     if (!fs::exists(pstate.build_root)) {
         int ret = mkdir(pstate.build_root.c_str(), 0777);
         if (ret != 0) {
@@ -286,8 +480,7 @@ void generate(const MIR::BasicBlock * const block, const MIR::State::Persistant
         }
     }
 
-    std::ofstream out{};
-    out.open(pstate.build_root / "build.ninja", std::ios::out | std::ios::trunc);
+    std::ostringstream out{};
     out << "# This is a build file for the project \"" << pstate.name << "\"." << std::endl
         << "# It is autogenerated by the Meson++ build system." << std::endl
         << "# Do not edit by hand." << std::endl
@@ -295,12 +488,66 @@ void generate(const MIR::BasicBlock * const block, const MIR::State::Persistant
         << "ninja_required_version = 1.8.2" << std::endl
         << std::endl;
 
+    // Targets that haven't changed since the last configure are neither lowered
+    // nor rendered again
+    Common::TargetCache cache{pstate.build_root / TARGET_CACHE};
+    const auto & rules = Common::mir_to_rules(block, pstate, &cache);
+
+    out << "# Job pools" << std::endl << std::endl;
+
+    if (pstate.options.backend_max_links != 0) {
+        out << "pool link_pool\n"
+            << "  depth = " << pstate.options.backend_max_links << "\n"
+            << std::endl;
+    }
+    if (pstate.options.backend_max_archives != 0) {
+        out << "pool archive_pool\n"
+            << "  depth = " << pstate.options.backend_max_archives << "\n"
+            << std::endl;
+    }
+
+    std::set<uint> target_pools{};
+    for (const auto & b : block->instructions) {
+        const MIR::Objects::BuildTarget * t = nullptr;
+        if (const auto e = std::get_if<std::unique_ptr<MIR::Executable>>(&b); e != nullptr) {
+            t = &(*e)->value;
+        } else if (const auto s = std::get_if<std::unique_ptr<MIR::StaticLibrary>>(&b);
+                   s != nullptr) {
+            t = &(*s)->value;
+        }
+        if (t != nullptr && t->link_pool_depth.value_or(0) != 0) {
+            target_pools.emplace(t->link_pool_depth.value());
+        }
+    }
+    for (const auto & d : target_pools) {
+        out << "pool " << Common::target_pool_name(d) << "\n"
+            << "  depth = " << d << "\n"
+            << std::endl;
+    }
+
     out << "# Compilation rules" << std::endl << std::endl;
 
     for (const auto & [l, tc] : pstate.toolchains) {
         const auto & lstr = MIR::Toolchain::to_string(l);
         // TODO: should also have a _for_host
-        write_compiler_rule(lstr, tc.build()->compiler, out);
+        write_compiler_rule(lstr, tc.build()->compiler, false, out);
+    }
+
+    out << "# Precompiled header rules" << std::endl << std::endl;
+
+    for (const auto & [l, tc] : pstate.toolchains) {
+        const auto & lstr = MIR::Toolchain::to_string(l);
+        // TODO: should also have a _for_host
+        write_compiler_rule(lstr, tc.build()->compiler, true, out);
+    }
+
+    out << "# C++ module scanning rules\n\n";
+
+    for (const auto & [l, tc] : pstate.toolchains) {
+        const auto & lstr = MIR::Toolchain::to_string(l);
+        // TODO: should also have a _for_host
+        write_scan_rule(lstr, tc.build()->compiler, out);
+        write_collate_rule(lstr, pstate, out);
     }
 
     out << "# Static Linking rules" << std::endl << std::endl;
@@ -308,7 +555,11 @@ void generate(const MIR::BasicBlock * const block, const MIR::State::Persistant
     for (const auto & [l, tc] : pstate.toolchains) {
         const auto & lstr = MIR::Toolchain::to_string(l);
         // TODO: should also have a _for_host
-        write_archiver_rule(lstr, tc.build()->archiver, out);
+        const auto & a = tc.build()->archiver;
+        write_archiver_rule(lstr, a, false, out);
+        if (a->rsp_support() == MIR::Toolchain::RSPFileSupport::GCC) {
+            write_archiver_rule(lstr, a, true, out);
+        }
     }
 
     out << "# Dynamic Linking rules" << std::endl << std::endl;
@@ -316,20 +567,71 @@ void generate(const MIR::BasicBlock * const block, const MIR::State::Persistant
     for (const auto & [l, tc] : pstate.toolchains) {
         const auto & lstr = MIR::Toolchain::to_string(l);
         // TODO: should also have a _for_host
-        write_linker_rule(lstr, tc.build()->linker, out);
+        const auto & lnk = tc.build()->linker;
+        write_linker_rule(lstr, lnk, false, out);
+        if (lnk->rsp_support() == MIR::Toolchain::RSPFileSupport::GCC) {
+            write_linker_rule(lstr, lnk, true, out);
+        }
     }
 
+    out << "# Regenerate the build files when the build definitions change\n\n";
+
+    write_regenerate_rule(pstate, out);
+
     out << "# Phony build target, always out of date\n\n"
         << "build PHONY: phony\n\n";
+    // Emit the edges with the longest chains first, so that ninja starts
+    // them as early as possible.
+    const Common::BuildGraph graph{rules};
+
+    // Interning is cheap, and doing it serially keeps the variable numbering stable
+    ArgumentTable arg_table{};
+    std::vector<std::string> arg_vars(graph.order.size());
+    for (std::size_t i = 0; i < graph.order.size(); ++i) {
+        const auto & r = *graph.edges[graph.order[i]].rule;
+        if (r.type == RuleType::COMPILE || r.type == RuleType::PCH) {
+            arg_vars[i] = arg_table.intern(r.lang, r.arguments);
+        }
+    }
+
+    out << "# Compile arguments\n\n";
+    arg_table.write(out);
+
     out << "# Build rules for targets\n\n";
 
-    const auto & rules = mir_to_rules(block, pstate);
-    for (const auto & r : rules) {
-        write_build_rule(r, out);
+    // Each edge is rendered into its slot in the cache, unless it's still
+    // there from the last configure.
+    std::unordered_map<const Rule *, std::string *> fragments{};
+    for (std::size_t t = 0; t < rules.size(); ++t) {
+        for (std::size_t r = 0; r < rules[t].size(); ++r) {
+            fragments.emplace(&rules[t][r], &cache.current[t].fragments[r]);
+        }
+    }
+
+    // Render the edges in parallel, then write them out in order.
+    Util::parallel_for(graph.order.size(), [&](std::size_t i) {
+        const auto & rule = *graph.edges[graph.order[i]].rule;
+        auto & fragment = *fragments.at(&rule);
+        if (fragment.empty()) {
+            std::ostringstream buf{};
+            write_build_rule(rule, arg_vars[i], pstate, buf);
+            fragment = buf.str();
+        }
+    });
+    for (const auto & e : graph.order) {
+        out << *fragments.at(graph.edges[e].rule);
     }
 
-    out.flush();
-    out.close();
+    // Leave an unchanged build.ninja alone, so that a regeneration which changed
+    // nothing doesn't look like a change to ninja.
+    Util::write_if_changed(pstate.build_root / "build.ninja", out.str());
+    cache.save();
+
+    write_compdb(rules, pstate);
+
+    auto files = generated_sources(rules);
+    files.insert(files.end(), {"build.ninja", "compile_commands.json", TARGET_CACHE});
+    return files;
 }
 
 } // namespace Backends::Ninja
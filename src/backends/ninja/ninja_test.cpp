@@ -0,0 +1,159 @@
+// SPDX-license-identifier: Apache-2.0
+// Copyright © 2021 Intel Corporation
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+
+#include "entry.hpp"
+#include "mir.hpp"
+#include "state/state.hpp"
+#include "tempdir.hpp"
+#include "toolchains/archiver.hpp"
+#include "toolchains/compilers/cpp/cpp.hpp"
+#include "toolchains/linker.hpp"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+/// The lines of the generated files, sorted
+std::vector<std::string> sorted_lines(const std::string & out) {
+    std::vector<std::string> lines{};
+    std::istringstream in{out};
+    for (std::string line; std::getline(in, line);) {
+        // The separators of the last entry in compile_commands.json differ
+        if (!line.empty() && line.back() == ',') {
+            line.pop_back();
+        }
+        lines.emplace_back(std::move(line));
+    }
+    std::sort(lines.begin(), lines.end());
+    return lines;
+}
+
+class NinjaTest : public ::testing::Test {
+  protected:
+    void SetUp() override {
+        fs::create_directories(src / "sub");
+        std::ofstream{src / "main.cpp"} << "int main() { return 0; }\n";
+        std::ofstream{src / "a.cpp"} << "int a() { return 1; }\n";
+        std::ofstream{src / "sub" / "lib.cpp"} << "int f() { return 1; }\n";
+    }
+
+    /**
+     * Generate the build into the build dir, and return the files written
+     *
+     * @param reversed Insert the options, arguments and targets in the opposite
+     *                 order, which changes how unordered containers iterate
+     */
+    std::string generate(const bool unity = false, const bool reversed = false) const {
+        namespace Toolchain = MIR::Toolchain;
+        const auto machine = MIR::Machines::Machine::BUILD;
+
+        MIR::State::Persistant pstate{src, build};
+        pstate.name = "determinism";
+        pstate.program = "/usr/bin/meson++";
+        pstate.build_files = {src / "meson.build", src / "sub" / "meson.build"};
+        std::vector<std::pair<std::string, std::string>> options{
+            {"cpp_std", "c++17"}, {"buildtype", "debug"}, {"warning_level", "3"}};
+        if (reversed) {
+            std::reverse(options.begin(), options.end());
+        }
+        pstate.cmdline_options.insert(options.begin(), options.end());
+        pstate.options.unity = unity;
+
+        const std::vector<std::string> init{"c++"};
+        auto comp = std::make_unique<Toolchain::Compiler::CPP::Gnu>(init);
+        const auto * c = comp.get();
+        pstate.toolchains[Toolchain::Language::CPP].set(
+            machine, std::make_shared<Toolchain::Toolchain>(
+                         std::move(comp),
+                         std::make_unique<Toolchain::Linker::Drivers::Gnu>(
+                             std::make_unique<Toolchain::Linker::GnuBFD>(init), c),
+                         std::make_unique<Toolchain::Archiver::Gnu>(
+                             std::vector<std::string>{"ar"})));
+
+        // Each target has its own arguments, built up in a different order
+        const auto make_args = [&](const std::string & define) {
+            MIR::Objects::ArgMap args{};
+            auto & cpp = args[Toolchain::Language::CPP];
+            cpp.emplace_back(define, MIR::Arguments::Type::DEFINE);
+            cpp.emplace_back("-Wall", MIR::Arguments::Type::RAW);
+            return args;
+        };
+
+        std::vector<MIR::Object> targets{};
+        std::vector<MIR::Objects::File> lsrcs{
+            MIR::Objects::File{"lib.cpp", "sub", false, src, build}};
+        targets.emplace_back(std::make_unique<MIR::StaticLibrary>(
+            MIR::Objects::StaticLibrary{"lib", lsrcs, machine, make_args("LIB")}));
+        std::vector<MIR::Objects::File> esrcs{
+            MIR::Objects::File{"main.cpp", "", false, src, build},
+            MIR::Objects::File{"a.cpp", "", false, src, build}};
+        targets.emplace_back(std::make_unique<MIR::Executable>(
+            MIR::Objects::Executable{"prog", esrcs, machine, make_args("PROG")}));
+        std::vector<MIR::Objects::File> osrcs{
+            MIR::Objects::File{"a.cpp", "", false, src, build}};
+        targets.emplace_back(std::make_unique<MIR::Executable>(
+            MIR::Objects::Executable{"other", osrcs, machine, make_args("OTHER")}));
+        if (reversed) {
+            std::reverse(targets.begin(), targets.end());
+        }
+
+        MIR::BasicBlock block{};
+        for (auto & t : targets) {
+            block.instructions.emplace_back(std::move(t));
+        }
+
+        Backends::Ninja::generate(&block, pstate);
+
+        std::string out{};
+        for (const auto & name : {"build.ninja", "compile_commands.json"}) {
+            std::ifstream in{build / name, std::ios::binary};
+            out.append(std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{});
+        }
+        return out;
+    }
+
+    const Util::TempDir tmp{"meson++-ninja-test"};
+    const fs::path src = tmp.path() / "src";
+    const fs::path build = tmp.path() / "build";
+};
+
+} // namespace
+
+TEST_F(NinjaTest, deterministic) {
+    const auto first = generate();
+    ASSERT_FALSE(first.empty());
+
+    fs::remove_all(build);
+    ASSERT_EQ(generate(), first);
+
+    // Targets are written in the order they're declared, but nothing else
+    // may depend on the order things were inserted in
+    fs::remove_all(build);
+    ASSERT_EQ(sorted_lines(generate(false, true)), sorted_lines(first));
+}
+
+TEST_F(NinjaTest, deterministic_with_cache) {
+    const auto first = generate();
+
+    // The second configure reuses the cached targets
+    ASSERT_EQ(generate(), first);
+}
+
+TEST_F(NinjaTest, deleted_unity_file) {
+    const auto first = generate(true);
+    const auto unity = build / "prog.p" / "unity_0.cpp";
+    ASSERT_TRUE(fs::exists(unity));
+
+    // The target is cached, but its unity file has to be written again
+    fs::remove_all(build / "prog.p");
+    ASSERT_EQ(generate(true), first);
+    ASSERT_TRUE(fs::exists(unity));
+}
@@ -0,0 +1,277 @@
+// SPDX-license-identifier: Apache-2.0
+// Copyright © 2021 Intel Corporation
+
+#include <array>
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "daemon.hpp"
+#include "exceptions.hpp"
+#include "serialize.hpp"
+#include "state/state.hpp"
+
+namespace fs = std::filesystem;
+
+namespace Daemon {
+
+namespace {
+
+/// The magic at the start of each request, the last byte is the version of the protocol
+constexpr std::array<char, 8> MAGIC{'M', 'P', 'P', 'D', 'M', 'N', '\0', 1};
+
+/// Closes a file descriptor when it goes out of scope
+class Socket {
+  public:
+    Socket(int f) : fd{f} {};
+    Socket(const Socket &) = delete;
+    Socket & operator=(const Socket &) = delete;
+    ~Socket() {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+
+    const int fd;
+};
+
+sockaddr_un address(const fs::path & socket) {
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (socket.native().size() >= sizeof(addr.sun_path)) {
+        throw Util::Exceptions::MesonException{"Socket path is too long: " + socket.string()};
+    }
+    std::strcpy(addr.sun_path, socket.c_str());
+    return addr;
+}
+
+/// Connect to the socket, returning -1 if nothing is listening on it
+int connect_to(const fs::path & socket) {
+    const int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    const auto addr = address(socket);
+    if (connect(fd, reinterpret_cast<const sockaddr *>(&addr), sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+bool write_all(int fd, const std::string & data) {
+    std::size_t done = 0;
+    while (done < data.size()) {
+        const ssize_t n = write(fd, data.data() + done, data.size() - done);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        done += n;
+    }
+    return true;
+}
+
+/// Read until the other end shuts down its side, or std::nullopt if reading fails or times out
+std::optional<std::string> read_all(int fd) {
+    std::string data{};
+    std::array<char, 4096> buf;
+    while (true) {
+        const ssize_t n = read(fd, buf.data(), buf.size());
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0) {
+            return std::nullopt;
+        }
+        if (n == 0) {
+            return data;
+        }
+        data.append(buf.data(), n);
+    }
+}
+
+void write_map(std::ostream & out, const std::map<std::string, std::string> & map) {
+    Util::write(out, static_cast<uint32_t>(map.size()));
+    for (const auto & [k, v] : map) {
+        Util::write(out, k);
+        Util::write(out, v);
+    }
+}
+
+bool read_map(Util::Reader & reader, std::map<std::string, std::string> & map) {
+    uint32_t count;
+    if (!reader.read(count)) {
+        return false;
+    }
+    for (uint32_t i = 0; i < count; ++i) {
+        std::string k, v;
+        if (!reader.read(k) || !reader.read(v)) {
+            return false;
+        }
+        map.emplace(std::move(k), std::move(v));
+    }
+    return true;
+}
+
+std::string reply(bool accepted, int status, const std::string & output) {
+    std::ostringstream out{};
+    Util::write(out, static_cast<uint8_t>(accepted));
+    Util::write(out, static_cast<int32_t>(status));
+    Util::write(out, output);
+    return out.str();
+}
+
+/// The executable, and when it was last written
+std::tuple<fs::path, fs::file_time_type> self() {
+    const auto exe = fs::read_symlink("/proc/self/exe");
+    std::error_code ec{};
+    return {exe, fs::last_write_time(exe, ec)};
+}
+
+/// Handle a single connection
+void handle(int fd, const Handler & handler,
+            const std::tuple<fs::path, fs::file_time_type> & started) {
+    // Only run configures for the user running the daemon
+    ucred cred{};
+    socklen_t len = sizeof(cred);
+    if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) != 0 || cred.uid != getuid()) {
+        return;
+    }
+
+    // A client that stalls is dropped, rather than holding up everyone after it
+    const auto data = read_all(fd);
+    if (!data.has_value()) {
+        return;
+    }
+    Util::Reader reader{data.value()};
+
+    std::array<char, MAGIC.size()> magic;
+    std::string program, sourcedir, builddir, cache_dir;
+    Request req{};
+    if (!reader.read(magic) || magic != MAGIC || !reader.read(program) ||
+        !reader.read(sourcedir) || !reader.read(builddir) || !reader.read(cache_dir) ||
+        !read_map(reader, req.options.options) || !read_map(reader, req.environment) ||
+        !reader.done()) {
+        write_all(fd, reply(false, 0, ""));
+        return;
+    }
+
+    // A different, or rebuilt, meson++ might not configure the same way, so
+    // leave it to the client.
+    if (self() != started || program != std::get<0>(started).string()) {
+        write_all(fd, reply(false, 0, ""));
+        return;
+    }
+
+    req.options.sourcedir = sourcedir;
+    req.options.builddir = builddir;
+    req.options.cache_dir = cache_dir;
+    const auto [status, output] = handler(req);
+    write_all(fd, reply(true, status, output));
+}
+
+} // namespace
+
+fs::path socket_path() {
+    if (const char * runtime = std::getenv("XDG_RUNTIME_DIR"); runtime != nullptr) {
+        return fs::path{runtime} / "meson++.sock";
+    }
+    return fs::temp_directory_path() / ("meson++-" + std::to_string(getuid()) + ".sock");
+}
+
+void serve(const fs::path & socket, const Handler & handler,
+           const std::chrono::milliseconds & timeout) {
+    if (const Socket other{connect_to(socket)}; other.fd >= 0) {
+        throw Util::Exceptions::MesonException{"A daemon is already listening on " +
+                                               socket.string()};
+    }
+    // Left behind by a daemon that was killed
+    std::error_code ec{};
+    fs::remove(socket, ec);
+
+    const Socket listener{::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0)};
+    const auto addr = address(socket);
+    if (listener.fd < 0 ||
+        bind(listener.fd, reinterpret_cast<const sockaddr *>(&addr), sizeof(addr)) != 0 ||
+        chmod(socket.c_str(), S_IRUSR | S_IWUSR) != 0 || listen(listener.fd, SOMAXCONN) != 0) {
+        throw Util::Exceptions::MesonException{"Could not listen on " + socket.string() + ": " +
+                                               std::strerror(errno)};
+    }
+
+    // A client going away shouldn't take the daemon with it
+    std::signal(SIGPIPE, SIG_IGN);
+
+    const auto started = self();
+    const timeval tv{static_cast<time_t>(timeout.count() / 1000),
+                     static_cast<suseconds_t>(timeout.count() % 1000 * 1000)};
+    while (true) {
+        const Socket client{accept4(listener.fd, nullptr, nullptr, SOCK_CLOEXEC)};
+        if (client.fd < 0) {
+            continue;
+        }
+        if (setsockopt(client.fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv)) != 0 ||
+            setsockopt(client.fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv)) != 0) {
+            continue;
+        }
+        handle(client.fd, handler, started);
+    }
+}
+
+std::optional<int> forward(const fs::path & socket, const Options::ConfigureOptions & opts) {
+    const Socket conn{connect_to(socket)};
+    if (conn.fd < 0) {
+        return std::nullopt;
+    }
+
+    // The daemon has its own working directory
+    const auto absolute = [](const fs::path & p) {
+        return p.empty() ? p : fs::absolute(p).lexically_normal();
+    };
+
+    std::map<std::string, std::string> environment{};
+    for (const auto & name : MIR::State::ENVIRONMENT) {
+        if (const char * value = std::getenv(name.c_str()); value != nullptr) {
+            environment.emplace(name, value);
+        }
+    }
+
+    std::ostringstream out{};
+    Util::write(out, MAGIC);
+    Util::write(out, fs::read_symlink("/proc/self/exe").string());
+    Util::write(out, absolute(opts.sourcedir).string());
+    Util::write(out, absolute(opts.builddir).string());
+    Util::write(out, absolute(opts.cache_dir).string());
+    write_map(out, opts.options);
+    write_map(out, environment);
+
+    if (!write_all(conn.fd, out.str()) || shutdown(conn.fd, SHUT_WR) != 0) {
+        return std::nullopt;
+    }
+
+    const auto data = read_all(conn.fd);
+    if (!data.has_value()) {
+        return std::nullopt;
+    }
+    Util::Reader reader{data.value()};
+    uint8_t accepted;
+    int32_t status;
+    std::string output;
+    if (!reader.read(accepted) || !reader.read(status) || !reader.read(output) || !accepted) {
+        return std::nullopt;
+    }
+    std::cout << output << std::flush;
+    return status;
+}
+
+} // namespace Daemon
@@ -0,0 +1,66 @@
+// SPDX-license-identifier: Apache-2.0
+// Copyright © 2021 Intel Corporation
+
+/**
+ * A resident configure server, and the client that forwards to it
+ *
+ * Requests are sent over a Unix domain socket, one per connection. The client
+ * writes the request and shuts down its side, then the daemon replies with
+ * the exit status and everything the configure printed.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <optional>
+#include <string>
+#include <tuple>
+
+#include "options.hpp"
+
+namespace Daemon {
+
+/// A configure, as sent to the daemon
+struct Request {
+    /// The configure options, with absolute paths
+    Options::ConfigureOptions options;
+
+    /// The environment variables that configure reads, unset ones are left out
+    std::map<std::string, std::string> environment;
+};
+
+/// Run a configure for the daemon, returning the exit status and the output
+using Handler = std::function<std::tuple<int, std::string>(const Request &)>;
+
+/// The socket of the current user's daemon, in $XDG_RUNTIME_DIR if it's set
+std::filesystem::path socket_path();
+
+/**
+ * Listen on the socket, and handle requests one at a time until killed
+ *
+ * Requests are only accepted from the same user, and from the same meson++
+ * executable as the daemon, which hasn't been rebuilt since it started.
+ *
+ * @param timeout How long a client may stall while sending its request or
+ *                reading the reply before it is dropped
+ * @throws Util::Exceptions::MesonException if the socket can't be listened on,
+ *         or another daemon is already listening
+ */
+[[noreturn]] void serve(const std::filesystem::path & socket, const Handler & handler,
+                        const std::chrono::milliseconds & timeout = std::chrono::seconds{5});
+
+/**
+ * Run a configure in the daemon, if one is running
+ *
+ * The output of the configure is written to stdout.
+ *
+ * @returns The exit status, or std::nullopt if there is no daemon that will
+ *          run the configure
+ */
+std::optional<int> forward(const std::filesystem::path & socket,
+                           const Options::ConfigureOptions & opts);
+
+} // namespace Daemon
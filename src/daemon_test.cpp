@@ -0,0 +1,64 @@
+// SPDX-license-identifier: Apache-2.0
+// Copyright © 2021 Intel Corporation
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <future>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+
+#include "daemon.hpp"
+#include "tempdir.hpp"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+/// Connect to the daemon, waiting for it to start listening
+int connect_when_listening(const fs::path & socket) {
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    std::strcpy(addr.sun_path, socket.c_str());
+    for (int i = 0; i < 100; ++i) {
+        const int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (connect(fd, reinterpret_cast<const sockaddr *>(&addr), sizeof(addr)) == 0) {
+            return fd;
+        }
+        close(fd);
+        std::this_thread::sleep_for(std::chrono::milliseconds{10});
+    }
+    return -1;
+}
+
+} // namespace
+
+TEST(daemon, stalled_client) {
+    const Util::TempDir tmp{"meson++-daemon-test"};
+    const auto socket = tmp.path() / "sock";
+
+    // serve never returns, it is left blocked in accept when the test ends
+    std::thread{[socket] {
+        Daemon::serve(
+            socket, [](const Daemon::Request &) { return std::make_tuple(3, std::string{}); },
+            std::chrono::milliseconds{100});
+    }}.detach();
+
+    // Connects, then never sends its request
+    const int stalled = connect_when_listening(socket);
+    ASSERT_GE(stalled, 0);
+
+    Options::ConfigureOptions opts{};
+    opts.sourcedir = tmp.path();
+    opts.builddir = tmp.path() / "build";
+    std::packaged_task<std::optional<int>()> task{
+        [socket, opts] { return Daemon::forward(socket, opts); }};
+    auto status = task.get_future();
+    std::thread{std::move(task)}.detach();
+
+    ASSERT_EQ(status.wait_for(std::chrono::seconds{10}), std::future_status::ready);
+    ASSERT_EQ(status.get(), 3);
+    close(stalled);
+}
@@ -9,11 +9,14 @@
 #include "node_visitors.hpp"
 #include "parser.yy.hpp"
 #include "scanner.hpp"
+#include "trace.hpp"
 
 namespace Frontend {
 
 std::unique_ptr<AST::CodeBlock> Driver::parse(const std::string & s) {
+    const Util::Trace::Span span{"parse", [&] { return Util::Trace::Args{{"file", s}}; }};
     name = s;
+    files.emplace_back(s);
 
     std::ifstream stream{s, std::ios_base::in | std::ios_base::binary};
 
@@ -30,7 +33,7 @@ std::unique_ptr<AST::CodeBlock> Driver::parse(std::istream & iss) {
     std::vector<AST::StatementV> new_stmts{};
 
     // Walk over all of the statements, replacing any subdir() calls with new
-    AST::SubdirVisitor sv{};
+    AST::SubdirVisitor sv{files};
     for (unsigned i = 0; i < block->statements.size(); ++i) {
         auto const & stmt = block->statements[i];
         auto res = std::visit(sv, stmt);
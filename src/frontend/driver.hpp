@@ -14,13 +14,16 @@ namespace Frontend {
 
 class Driver {
   public:
-    Driver(){};
+    Driver() : files{} {};
     ~Driver(){};
 
     std::unique_ptr<AST::CodeBlock> parse(std::istream &);
     std::unique_ptr<AST::CodeBlock> parse(const std::string &);
 
     std::string name;
+
+    /// Every file read, including those pulled in by `subdir()` calls
+    std::vector<std::string> files;
 };
 
 } // namespace Frontend
@@ -4,6 +4,8 @@
 #pragma once
 
 #include <optional>
+#include <string>
+#include <vector>
 
 #include "node.hpp"
 
@@ -13,6 +15,8 @@ namespace Frontend::AST {
  * Convert all `subdir()` calls into AST and insert it into the tree.
  */
 struct SubdirVisitor {
+    SubdirVisitor(std::vector<std::string> & f) : files{f} {};
+
     std::optional<std::unique_ptr<CodeBlock>> operator()(const std::unique_ptr<Statement> &) const;
     std::optional<std::unique_ptr<CodeBlock>>
     operator()(const std::unique_ptr<IfStatement> &) const;
@@ -30,6 +34,9 @@ struct SubdirVisitor {
     std::optional<std::unique_ptr<CodeBlock>> operator()(const std::unique_ptr<Continue> &) const {
         return std::nullopt;
     };
+
+    /// The files read so far, which any subdir() files are added to
+    std::vector<std::string> & files;
 };
 
 } // namespace Frontend::AST
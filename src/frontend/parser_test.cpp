@@ -1,6 +1,8 @@
 // SPDX-license-identifier: Apache-2.0
 // Copyright © 2021 Intel Corporation
 
+#include <filesystem>
+#include <fstream>
 #include <gtest/gtest.h>
 #include <memory>
 #include <sstream>
@@ -8,6 +10,7 @@
 
 #include "driver.hpp"
 #include "node.hpp"
+#include "tempdir.hpp"
 
 static std::unique_ptr<Frontend::AST::CodeBlock> parse(const std::string & in) {
     Frontend::Driver drv{};
@@ -414,3 +417,17 @@ TEST(parser, inline_comment) {
     auto block = parse("a = b  # foo\n");
     ASSERT_EQ(block->statements.size(), 1);
 }
+
+TEST(driver, files) {
+    const Util::TempDir tmp{"meson++-driver-files"};
+    const auto & root = tmp.path();
+    std::filesystem::create_directories(root / "sub");
+    std::ofstream{root / "meson.build"} << "if true\n  subdir('sub')\nendif\n";
+    std::ofstream{root / "sub" / "meson.build"} << "x = 1\n";
+
+    Frontend::Driver drv{};
+    auto block = drv.parse(root / "meson.build");
+
+    const std::vector<std::string> expected{root / "meson.build", root / "sub" / "meson.build"};
+    ASSERT_EQ(drv.files, expected);
+}
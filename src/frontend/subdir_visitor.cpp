@@ -6,6 +6,7 @@
 #include "driver.hpp"
 #include "exceptions.hpp"
 #include "node_visitors.hpp"
+#include "trace.hpp"
 
 namespace Frontend::AST {
 
@@ -15,8 +16,8 @@ namespace {
  * Walk a code block and rewrite any subdir() calls with the code in file
  * referenced
  */
-void subdir_replacer(std::unique_ptr<CodeBlock> & block) {
-    SubdirVisitor sv{};
+void subdir_replacer(std::unique_ptr<CodeBlock> & block, std::vector<std::string> & files) {
+    SubdirVisitor sv{files};
     std::vector<StatementV> new_stmts{};
 
     // TODO: this code is basically copied out of the driver, how can we share it?
@@ -91,20 +92,24 @@ SubdirVisitor::operator()(const std::unique_ptr<Statement> & stmt) const {
                                                  "."};
     }
 
+    const Util::Trace::Span span{"subdir",
+                                 [&] { return Util::Trace::Args{{"dir", dir->value}}; }};
     Driver drv{};
-    return drv.parse(p);
+    auto block = drv.parse(p);
+    files.insert(files.end(), drv.files.begin(), drv.files.end());
+    return block;
 };
 
 std::optional<std::unique_ptr<CodeBlock>>
 SubdirVisitor::operator()(const std::unique_ptr<IfStatement> & stmt) const {
-    subdir_replacer(stmt->ifblock.block);
+    subdir_replacer(stmt->ifblock.block, files);
     if (!stmt->efblock.empty()) {
         for (auto & s : stmt->efblock) {
-            subdir_replacer(s.block);
+            subdir_replacer(s.block, files);
         }
     }
     if (stmt->eblock.block) {
-        subdir_replacer(stmt->eblock.block);
+        subdir_replacer(stmt->eblock.block, files);
     }
 
     // XXX: this is kinda gross...
@@ -5,43 +5,287 @@
  * Main Meson++ entrypoint
  */
 
+#include <chrono>
+#include <cstdlib>
 #include <filesystem>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <utility>
 
 #include "ast_to_mir.hpp"
+#include "backends/executor/executor.hpp"
 #include "backends/ninja/entry.hpp"
+#include "backends/ninja/modules.hpp"
+#include "daemon.hpp"
 #include "driver.hpp"
 #include "exceptions.hpp"
 #include "log.hpp"
 #include "lower.hpp"
 #include "options.hpp"
+#include "state/cache.hpp"
 #include "state/state.hpp"
+#include "trace.hpp"
 #include "version.hpp"
+#include "watch.hpp"
 
 namespace fs = std::filesystem;
 
-static int configure(const Options::ConfigureOptions & opts) {
+/**
+ * What the daemon keeps of a build directory between configures
+ *
+ * The AST is kept for as long as none of the files it was parsed from change.
+ */
+struct Session {
+    /// The build files of the AST, as they were when it was parsed
+    MIR::State::Fingerprint fingerprint;
+    std::unique_ptr<Frontend::AST::CodeBlock> ast;
+};
+
+/// Options from the last configure are kept unless they are set again
+static std::map<std::string, std::string> merged_options(const Options::ConfigureOptions & opts,
+                                                         const MIR::State::Persistant & pstate) {
+    auto options = pstate.cmdline_options;
+    for (const auto & [k, v] : opts.options) {
+        options.insert_or_assign(k, v);
+    }
+    return options;
+}
+
+/// Parse the project and lower it, ready to be handed to a backend
+static MIR::BasicBlock lower_project(const Options::ConfigureOptions & opts,
+                                     MIR::State::Persistant & pstate,
+                                     Session * session = nullptr) {
     std::cout << Util::Log::bold("The Meson++ build system") << std::endl
               << "Version: " << version::VERSION << std::endl
               << "Source dir: " << Util::Log::bold(fs::absolute(opts.sourcedir)) << std::endl
               << "Build dir: " << Util::Log::bold(fs::absolute(opts.builddir)) << std::endl;
 
-    // Parse the source into a an AST
-    Frontend::Driver drv{};
-    auto block = drv.parse(opts.sourcedir / "meson.build");
+    // Parse the source into a an AST, unless the daemon has it already
+    std::unique_ptr<Frontend::AST::CodeBlock> parsed{};
+    if (session != nullptr && session->ast != nullptr &&
+        !session->fingerprint.build_files.empty() &&
+        !MIR::State::build_files_changed(session->fingerprint)) {
+        pstate.build_files.clear();
+        for (const auto & f : session->fingerprint.build_files) {
+            pstate.build_files.emplace_back(f.path);
+        }
+    } else {
+        Frontend::Driver drv{};
+        parsed = drv.parse(opts.sourcedir / "meson.build");
+        pstate.build_files.clear();
+        for (const auto & f : drv.files) {
+            pstate.build_files.emplace_back(fs::absolute(f).lexically_normal());
+        }
+    }
+    const auto & block = parsed != nullptr ? parsed : session->ast;
 
-    MIR::State::Persistant pstate{opts.sourcedir, opts.builddir};
+    pstate.cmdline_options = merged_options(opts, pstate);
+    MIR::State::set_options(pstate.options, pstate.cmdline_options);
 
     // Create IR from the AST, then run our lowering passes on it
-    auto irlist = MIR::lower_ast(block, pstate);
-    MIR::Passes::lower_project(&irlist, pstate);
+    auto irlist = [&] {
+        const Util::Trace::Span span{"lower_ast"};
+        return MIR::lower_ast(block, pstate);
+    }();
+    {
+        const Util::Trace::Span span{"lower_project"};
+        MIR::Passes::lower_project(&irlist, pstate);
+    }
     MIR::lower(&irlist, pstate);
 
-    Backends::Ninja::generate(&irlist, pstate);
+    if (parsed != nullptr && session != nullptr) {
+        // The fingerprint is filled in once the state is saved
+        session->ast = std::move(parsed);
+        session->fingerprint = {};
+    }
+
+    return irlist;
+}
+
+/**
+ * Get the state of the last configure of the build directory, or a new state
+ *
+ * Toolchains are detected again if anything used to find them has changed.
+ */
+static MIR::State::Persistant initial_state(const Options::ConfigureOptions & opts) {
+    const auto program = fs::read_symlink("/proc/self/exe");
+
+    auto loaded = MIR::State::load(opts.builddir);
+    if (!loaded.has_value() || fs::absolute(loaded->source_root).lexically_normal() !=
+                                   fs::absolute(opts.sourcedir).lexically_normal()) {
+        MIR::State::Persistant pstate{opts.sourcedir, opts.builddir};
+        pstate.program = program;
+        return pstate;
+    }
+
+    auto & pstate = loaded.value();
+    pstate.program = program;
+    auto options = pstate.options;
+    MIR::State::set_options(options, opts.options);
+    if (options.cpp_launcher != pstate.options.cpp_launcher ||
+        options.cpp_ld != pstate.options.cpp_ld || MIR::State::toolchains_changed(pstate)) {
+        pstate.toolchains.clear();
+    }
+    return std::move(pstate);
+}
+
+static int configure(const Options::ConfigureOptions & opts, Session * session = nullptr) {
+    const Util::Trace::Span span{"configure"};
+    auto pstate = initial_state(opts);
+
+    // CI scripts configure unconditionally, so make that cheap when nothing changed
+    if (MIR::State::up_to_date(pstate, opts.options) &&
+        fs::exists(opts.builddir / "build.ninja")) {
+        std::cout << "Build directory " << Util::Log::bold(fs::absolute(opts.builddir))
+                  << " is up to date" << std::endl;
+        MIR::State::save(pstate);
+        return 0;
+    }
+
+    std::optional<MIR::State::ConfigureCache> cache{};
+    if (!opts.cache_dir.empty()) {
+        cache.emplace(opts.cache_dir, pstate, merged_options(opts, pstate));
+        if (cache->restore()) {
+            std::cout << "Build directory " << Util::Log::bold(fs::absolute(opts.builddir))
+                      << " restored from " << Util::Log::bold(opts.cache_dir) << std::endl;
+            return 0;
+        }
+    }
+
+    const auto irlist = lower_project(opts, pstate, session);
+
+    const auto files = [&] {
+        const Util::Trace::Span span{"generate"};
+        return Backends::Ninja::generate(&irlist, pstate);
+    }();
+    MIR::State::save(pstate);
+    if (cache.has_value()) {
+        cache->store(files);
+    }
+    if (session != nullptr && session->fingerprint.build_files.empty()) {
+        if (const auto saved = MIR::State::load(opts.builddir); saved.has_value()) {
+            session->fingerprint = saved->fingerprint;
+        }
+    }
 
     return 0;
 };
 
+static int compile(const Options::CompileOptions & opts) {
+    auto pstate = initial_state(opts.config);
+    const auto irlist = lower_project(opts.config, pstate);
+    MIR::State::save(pstate);
+
+    return Backends::Executor::build(&irlist, pstate, opts.jobs) ? 0 : 1;
+};
+
+/**
+ * Run configures sent by clients, keeping each build directory's AST between them
+ *
+ * Probing the toolchains is already skipped using the saved state, so this
+ * saves the parse and the process start up.
+ */
+static int run_daemon() {
+    // A build directory configured against another source dir starts over
+    std::map<std::pair<fs::path, fs::path>, Session> sessions{};
+
+    const auto handler = [&](const Daemon::Request & req) -> std::tuple<int, std::string> {
+        for (const auto & name : MIR::State::ENVIRONMENT) {
+            if (const auto v = req.environment.find(name); v != req.environment.end()) {
+                setenv(name.c_str(), v->second.c_str(), 1);
+            } else {
+                unsetenv(name.c_str());
+            }
+        }
+
+        std::ostringstream output{};
+        auto * out = std::cout.rdbuf(output.rdbuf());
+        auto * err = std::cerr.rdbuf(output.rdbuf());
+        const auto key = std::make_pair(req.options.sourcedir, req.options.builddir);
+        int ret = 1;
+        try {
+            ret = configure(req.options, &sessions[key]);
+        } catch (Util::Exceptions::MesonException & e) {
+            std::cerr << e.message << std::endl;
+        } catch (std::exception & e) {
+            std::cerr << e.what() << std::endl;
+        }
+        std::cout.rdbuf(out);
+        std::cerr.rdbuf(err);
+
+        if (ret != 0) {
+            sessions.erase(key);
+        }
+        return {ret, output.str()};
+    };
+
+    const auto socket = Daemon::socket_path();
+    std::cout << "Listening on " << Util::Log::bold(socket) << std::endl;
+    Daemon::serve(socket, handler);
+}
+
+/**
+ * Configure, then configure again each time a build file changes, until killed
+ *
+ * Only the saved state is reused between configures: every build file is
+ * parsed again, but toolchains are not detected again, and backend outputs
+ * that come out the same are left alone.
+ */
+static int watch(const Options::ConfigureOptions & opts) {
+    Util::Watcher watcher{};
+    // Until a configure succeeds only the root is known
+    std::vector<fs::path> files{fs::absolute(opts.sourcedir / "meson.build").lexically_normal()};
+
+    while (true) {
+        bool ok = false;
+        try {
+            ok = configure(opts) == 0;
+        } catch (Util::Exceptions::MesonException & e) {
+            std::cerr << e.message << std::endl;
+        } catch (std::exception & e) {
+            std::cerr << e.what() << std::endl;
+        }
+        Util::Trace::write();
+
+        // A failed configure isn't saved, so keep watching what the last good one read
+        const auto saved = MIR::State::load(opts.builddir);
+        if (saved.has_value()) {
+            files = saved->build_files;
+        }
+        watcher.watch(files);
+
+        // Files in directories that weren't watched yet may have changed while configuring
+        if (ok && saved.has_value() && MIR::State::build_files_changed(saved->fingerprint)) {
+            continue;
+        }
+
+        std::cout << "Watching " << files.size() << " build files for changes" << std::endl;
+        for (const auto & f : watcher.wait(std::chrono::milliseconds{100})) {
+            std::cout << "Changed: " << f.string() << std::endl;
+        }
+    }
+}
+
+/// Commands run by the generated build files
+static int internal(const Options::InternalOptions & opts) {
+    const auto & args = opts.arguments;
+    if (opts.command == "collate-modules") {
+        // <compiler id> <map> <dyndep> <scan results...>
+        if (args.size() < 3) {
+            throw Util::Exceptions::InvalidArguments{
+                "collate-modules requires a compiler id, map, and dyndep file"};
+        }
+        const std::vector<fs::path> ddis(args.begin() + 3, args.end());
+        Backends::Ninja::write_module_files(args[0], args[1], args[2], ddis);
+        return 0;
+    }
+    throw Util::Exceptions::InvalidArguments{"Unknown internal command \"" + opts.command +
+                                             "\""};
+}
+
 int main(int argc, char * argv[]) {
     const auto opts = Options::parse_opts(argc, argv);
 
@@ -50,13 +294,38 @@ int main(int argc, char * argv[]) {
     try {
         switch (opts.verb) {
             case Options::Verb::CONFIGURE:
+                if (!opts.config.trace.empty()) {
+                    Util::Trace::start(opts.config.trace);
+                }
+                if (opts.config.watch) {
+                    ret = watch(opts.config);
+                    break;
+                }
+                // A trace has to be taken in this process
+                if (opts.config.trace.empty()) {
+                    if (const auto status = Daemon::forward(Daemon::socket_path(), opts.config);
+                        status.has_value()) {
+                        return status.value();
+                    }
+                }
                 ret = configure(opts.config);
                 break;
+            case Options::Verb::COMPILE:
+                ret = compile(opts.compile);
+                break;
+            case Options::Verb::INTERNAL:
+                ret = internal(opts.internal);
+                break;
+            case Options::Verb::DAEMON:
+                ret = run_daemon();
+                break;
         };
 
+        Util::Trace::write();
         return ret;
     } catch (Util::Exceptions::MesonException & e) {
         std::cerr << e.message << std::endl;
+        Util::Trace::write();
         return 1;
     }
 
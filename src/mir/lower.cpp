@@ -1,14 +1,22 @@
 // SPDX-license-identifier: Apache-2.0
 // Copyright © 2021 Intel Corporation
 
+#include <string>
+
 #include "lower.hpp"
+#include "trace.hpp"
 
 namespace MIR {
 
 void lower(BasicBlock * block, State::Persistant & pstate) {
     bool progress;
+    uint iteration = 0;
     // clang-format off
     do {
+        const Util::Trace::Span span{"lower iteration", [&] {
+            return Util::Trace::Args{{"iteration", std::to_string(iteration)}};
+        }};
+        ++iteration;
         progress = false
             || Passes::machine_lower(block, pstate.machines)
             || Passes::insert_compilers(block, pstate.toolchains)
@@ -70,14 +70,13 @@ template <typename T> class PerMachine {
         : _build{std::move(_b)}, _host{std::move(std::nullopt)}, _target{
                                                                      std::move(std::nullopt)} {};
     PerMachine(PerMachine<T> && t)
-        : _build{std::move(t._build)}, _target{std::move(t._target)}, _host{
-                                                                          std::move(t._target)} {};
+        : _build{std::move(t._build)}, _host{std::move(t._host)}, _target{std::move(t._target)} {};
     ~PerMachine(){};
 
     PerMachine<T> & operator=(PerMachine<T> && t) {
         _build = std::move(t._build);
+        _host = std::move(t._host);
         _target = std::move(t._target);
-        _host = std::move(t._target);
         return *this;
     }
 
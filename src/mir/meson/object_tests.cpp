@@ -46,3 +46,13 @@ TEST(file, static_relative_to_source_subdir) {
     File f{"foo.c", "sub", false, "/home/user/src", "/home/user/src/build"};
     ASSERT_EQ(f.relative_to_source_dir(), "sub/foo.c");
 }
+
+TEST(file, static_absolute_path) {
+    File f{"foo.c", "sub", false, "/home/user/src", "/home/user/src/build"};
+    ASSERT_EQ(f.absolute_path(), "/home/user/src/sub/foo.c");
+}
+
+TEST(file, built_absolute_path) {
+    File f{"foo.c", "sub", true, "/home/user/src", "/home/user/src/build"};
+    ASSERT_EQ(f.absolute_path(), "/home/user/src/build/sub/foo.c");
+}
@@ -10,8 +10,9 @@
 #pragma once
 
 #include <filesystem>
+#include <map>
+#include <optional>
 #include <string>
-#include <unordered_map>
 #include <vector>
 
 #include "arguments.hpp"
@@ -22,7 +23,7 @@ namespace fs = std::filesystem;
 
 namespace MIR::Objects {
 
-using ArgMap = std::unordered_map<Toolchain::Language, std::vector<Arguments::Argument>>;
+using ArgMap = std::map<Toolchain::Language, std::vector<Arguments::Argument>>;
 
 /**
  * A Meson File, which is a smart object that knows its location relative to the
@@ -47,6 +48,9 @@ class File {
     /// Get a path for this file relative to the build treeZ
     const fs::path relative_to_build_dir() const;
 
+    /// Get the absolute path to this file
+    const fs::path absolute_path() const;
+
   private:
     const std::string name;
     const fs::path subdir;
@@ -79,10 +83,30 @@ class BuildTarget {
      */
     const ArgMap arguments;
 
+    /**
+     * Override for the depth of the job pool used to link this target
+     *
+     * If this is unset the backend's default pool is used, if it is 0 the
+     * target isn't placed in any pool.
+     */
+    const std::optional<uint> link_pool_depth;
+
+    /// A header to precompile and use for all C++ sources in this target
+    const std::optional<File> cpp_pch;
+
+    /// Built-in options overridden for this target, as option : value
+    const std::map<std::string, std::string> override_options;
+
+    /// Whether this target is installed, or only used inside the build
+    const bool install;
+
   protected:
     BuildTarget(const std::string & name_, const std::vector<File> & srcs,
-                const Machines::Machine & m, const ArgMap & args)
-        : name{name_}, sources{srcs}, machine{m}, arguments{args} {};
+                const Machines::Machine & m, const ArgMap & args,
+                const std::optional<uint> & pool, const std::optional<File> & pch,
+                const std::map<std::string, std::string> & overrides, const bool & inst)
+        : name{name_}, sources{srcs}, machine{m}, arguments{args}, link_pool_depth{pool},
+          cpp_pch{pch}, override_options{overrides}, install{inst} {};
 };
 
 /**
@@ -91,8 +115,12 @@ class BuildTarget {
 class Executable : public BuildTarget {
   public:
     Executable(const std::string & name_, const std::vector<File> & srcs,
-               const Machines::Machine & m, const ArgMap & args)
-        : BuildTarget{name_, srcs, m, args} {};
+               const Machines::Machine & m, const ArgMap & args,
+               const std::optional<uint> & pool = std::nullopt,
+               const std::optional<File> & pch = std::nullopt,
+               const std::map<std::string, std::string> & overrides = {},
+               const bool & inst = false)
+        : BuildTarget{name_, srcs, m, args, pool, pch, overrides, inst} {};
 };
 
 /**
@@ -101,8 +129,12 @@ class Executable : public BuildTarget {
 class StaticLibrary : public BuildTarget {
   public:
     StaticLibrary(const std::string & name_, const std::vector<File> & srcs,
-                  const Machines::Machine & m, const ArgMap & args)
-        : BuildTarget{name_, srcs, m, args} {};
+                  const Machines::Machine & m, const ArgMap & args,
+                  const std::optional<uint> & pool = std::nullopt,
+                  const std::optional<File> & pch = std::nullopt,
+                  const std::map<std::string, std::string> & overrides = {},
+                  const bool & inst = false)
+        : BuildTarget{name_, srcs, m, args, pool, pch, overrides, inst} {};
 };
 
 } // namespace MIR::Objects
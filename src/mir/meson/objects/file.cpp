@@ -38,4 +38,8 @@ const std::filesystem::path File::relative_to_build_dir() const {
     }
 }
 
+const std::filesystem::path File::absolute_path() const {
+    return ((built ? build_root : source_root) / subdir / name).lexically_normal();
+}
+
 } // namespace MIR::Objects
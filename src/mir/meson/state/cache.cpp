@@ -0,0 +1,118 @@
+// SPDX-license-identifier: Apache-2.0
+// Copyright © 2021 Intel Corporation
+
+#include <iomanip>
+#include <sstream>
+#include <unistd.h>
+
+#include "hash.hpp"
+#include "io.hpp"
+#include "state/cache.hpp"
+
+namespace fs = std::filesystem;
+
+namespace MIR::State {
+
+namespace {
+
+/// Bumped whenever the layout of an entry changes
+constexpr uint64_t VERSION = 1;
+
+std::string to_hex(const uint64_t & value) {
+    std::ostringstream out{};
+    out << std::hex << std::setw(16) << std::setfill('0') << value;
+    return out.str();
+}
+
+fs::path cache_dir(const fs::path & dir, const Persistant & pstate,
+                   const std::map<std::string, std::string> & options) {
+    Util::Hasher h{};
+    h.add(VERSION);
+    h.add(pstate.program.string());
+    std::error_code ec{};
+    if (const auto time = fs::last_write_time(pstate.program, ec); !ec) {
+        h.add(static_cast<uint64_t>(time.time_since_epoch().count()));
+        h.add(static_cast<uint64_t>(fs::file_size(pstate.program, ec)));
+    }
+    h.add(fs::absolute(pstate.source_root).lexically_normal().string());
+    h.add(fs::absolute(pstate.build_root).lexically_normal().string());
+    for (const auto & [k, v] : options) {
+        h.add(k).add(v);
+    }
+    return dir / to_hex(h.digest());
+}
+
+/// The key of an entry within its directory, from the fingerprint of the configure
+std::string entry_name(const Fingerprint & fp) {
+    Util::Hasher h{};
+    for (const auto & f : fp.build_files) {
+        h.add(f.path.string()).add(f.hash);
+    }
+    for (const auto & p : fp.programs) {
+        h.add(p.path.string()).add(static_cast<uint64_t>(p.mtime)).add(p.size);
+    }
+    h.add(fp.environment);
+    return to_hex(h.digest());
+}
+
+} // namespace
+
+ConfigureCache::ConfigureCache(const fs::path & d, const Persistant & pstate,
+                               const std::map<std::string, std::string> & o)
+    : dir{cache_dir(d, pstate, o)}, build_root{pstate.build_root}, options{o} {};
+
+bool ConfigureCache::restore() const {
+    std::error_code ec{};
+    for (const auto & entry : fs::directory_iterator{dir, ec}) {
+        // Entries that are still being written have a suffix
+        if (!entry.is_directory() || entry.path().has_extension()) {
+            continue;
+        }
+        const auto candidate = load(entry.path());
+        if (!candidate.has_value() || !up_to_date(candidate.value(), options)) {
+            continue;
+        }
+
+        for (const auto & f : fs::recursive_directory_iterator{entry.path()}) {
+            if (!f.is_regular_file()) {
+                continue;
+            }
+            const auto dest = build_root / f.path().lexically_relative(entry.path());
+            fs::create_directories(dest.parent_path());
+            Util::clone_file(f.path(), dest);
+        }
+        return true;
+    }
+    return false;
+}
+
+void ConfigureCache::store(const std::vector<fs::path> & files) const {
+    const auto saved = load(build_root);
+    if (!saved.has_value()) {
+        return;
+    }
+    const auto name = entry_name(saved->fingerprint);
+    const auto entry = dir / name;
+    if (fs::exists(entry)) {
+        return;
+    }
+
+    // Fill in a temporary directory and then move it into place, so that other
+    // jobs using the cache never see half of an entry.
+    const auto tmp = dir / (name + "." + std::to_string(getpid()));
+    std::vector<fs::path> all = files;
+    all.emplace_back(STATE_FILE);
+    for (const auto & f : all) {
+        fs::create_directories((tmp / f).parent_path());
+        Util::clone_file(build_root / f, tmp / f);
+    }
+
+    std::error_code ec{};
+    fs::rename(tmp, entry, ec);
+    if (ec) {
+        // Another job stored the same configure first
+        fs::remove_all(tmp, ec);
+    }
+}
+
+} // namespace MIR::State
@@ -0,0 +1,67 @@
+// SPDX-license-identifier: Apache-2.0
+// Copyright © 2021 Intel Corporation
+
+/**
+ * A cache of whole configures, which can be shared between build directories
+ */
+
+#pragma once
+
+#include <filesystem>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "state/state.hpp"
+
+namespace MIR::State {
+
+/**
+ * Configures keyed by their inputs
+ *
+ * Configuring is deterministic, so a build directory configured from the same
+ * inputs as one before it can be copied instead of evaluated. Entries are
+ * grouped by everything that is known before parsing: meson++, the source
+ * and build roots, and the options. Each entry in the group is then checked
+ * against the fingerprint of the configure that made it.
+ *
+ * The generated files hold absolute paths, so entries are only shared between
+ * build directories at the same path, such as CI jobs using the same
+ * workspace, or a checkout going back to a commit it was configured at.
+ */
+class ConfigureCache {
+  public:
+    /**
+     * @param dir The directory of the cache
+     * @param pstate The state of the build directory, before configuring
+     * @param options Every option from the command line, including those kept
+     *                from the last configure
+     */
+    ConfigureCache(const std::filesystem::path & dir, const Persistant & pstate,
+                   const std::map<std::string, std::string> & options);
+
+    /**
+     * Copy a configure with the same inputs into the build directory
+     *
+     * @returns true if one was found
+     */
+    bool restore() const;
+
+    /**
+     * Add a finished configure to the cache
+     *
+     * @param files The files written into the build directory by the backend,
+     *              relative to it. The saved state is added to these.
+     */
+    void store(const std::vector<std::filesystem::path> & files) const;
+
+  private:
+    /// The directory holding every configure with the same key
+    const std::filesystem::path dir;
+
+    const std::filesystem::path build_root;
+
+    const std::map<std::string, std::string> options;
+};
+
+} // namespace MIR::State
@@ -0,0 +1,104 @@
+// SPDX-license-identifier: Apache-2.0
+// Copyright © 2021 Intel Corporation
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+#include "state/cache.hpp"
+#include "tempdir.hpp"
+#include "toolchains/compilers/cpp/cpp.hpp"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+std::string read(const fs::path & path) {
+    std::ifstream in{path, std::ios::binary};
+    return std::string{std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{}};
+}
+
+class ConfigureCacheTest : public ::testing::Test {
+  protected:
+    void SetUp() override {
+        fs::create_directories(src);
+        std::ofstream{src / "meson.build"} << "project('p', 'cpp')\n";
+    }
+
+    /// Configure the build directory, and store it in the cache
+    void configure(const std::map<std::string, std::string> & options) const {
+        namespace Toolchain = MIR::Toolchain;
+
+        MIR::State::Persistant pstate{src, build};
+        pstate.build_files = {src / "meson.build"};
+        pstate.cmdline_options = options;
+
+        auto comp = std::make_unique<Toolchain::Compiler::CPP::Gnu>(
+            std::vector<std::string>{"g++"});
+        const auto * c = comp.get();
+        pstate.toolchains[Toolchain::Language::CPP].set(
+            MIR::Machines::Machine::BUILD,
+            std::make_shared<Toolchain::Toolchain>(
+                std::move(comp),
+                std::make_unique<Toolchain::Linker::Drivers::Gnu>(
+                    std::make_unique<Toolchain::Linker::GnuBFD>(std::vector<std::string>{"g++"}),
+                    c)));
+
+        const MIR::State::ConfigureCache configure_cache{cache, pstate, options};
+        fs::create_directories(build / "prog.p");
+        std::ofstream{build / "build.ninja"} << "build prog: phony\n";
+        std::ofstream{build / "prog.p" / "unity_0.cpp"} << "#include \"main.cpp\"\n";
+        MIR::State::save(pstate);
+        configure_cache.store({"build.ninja", "prog.p/unity_0.cpp"});
+        fs::remove_all(build);
+    }
+
+    /// Try to restore the build directory, as a new configure would
+    bool restore(const std::map<std::string, std::string> & options) const {
+        const MIR::State::Persistant pstate{src, build};
+        return MIR::State::ConfigureCache{cache, pstate, options}.restore();
+    }
+
+    const Util::TempDir tmp{"meson++-cache-test"};
+    const fs::path src = tmp.path() / "src";
+    const fs::path build = tmp.path() / "build";
+    const fs::path cache = tmp.path() / "cache";
+};
+
+} // namespace
+
+TEST_F(ConfigureCacheTest, restore) {
+    configure({{"unity", "on"}});
+    ASSERT_TRUE(restore({{"unity", "on"}}));
+
+    ASSERT_EQ(read(build / "build.ninja"), "build prog: phony\n");
+    ASSERT_EQ(read(build / "prog.p" / "unity_0.cpp"), "#include \"main.cpp\"\n");
+    const auto loaded = MIR::State::load(build);
+    ASSERT_TRUE(loaded.has_value());
+    ASSERT_EQ(loaded->cmdline_options.at("unity"), "on");
+    ASSERT_EQ(loaded->toolchains.at(MIR::Toolchain::Language::CPP).build()->compiler->id(),
+              "gcc");
+}
+
+TEST_F(ConfigureCacheTest, empty) { ASSERT_FALSE(restore({})); }
+
+TEST_F(ConfigureCacheTest, different_options) {
+    configure({{"unity", "on"}});
+    ASSERT_FALSE(restore({}));
+    ASSERT_FALSE(restore({{"unity", "off"}}));
+}
+
+TEST_F(ConfigureCacheTest, changed_build_file) {
+    configure({});
+    std::ofstream{src / "meson.build"} << "project('q', 'cpp')\n";
+    ASSERT_FALSE(restore({}));
+
+    // Both versions can be restored once they have been configured
+    configure({});
+    ASSERT_TRUE(restore({}));
+    std::ofstream{src / "meson.build"} << "project('p', 'cpp')\n";
+    ASSERT_TRUE(restore({}));
+    ASSERT_EQ(MIR::State::load(build)->build_files.size(), 1);
+}
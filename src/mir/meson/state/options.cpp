@@ -0,0 +1,131 @@
+// SPDX-license-identifier: Apache-2.0
+// Copyright © 2021 Intel Corporation
+
+#include <algorithm>
+#include <cstdint>
+#include <set>
+#include <unistd.h>
+
+#include "exceptions.hpp"
+#include "state/options.hpp"
+
+namespace MIR::State {
+
+namespace {
+
+/**
+ * Guess how many concurrent jobs fit in memory
+ *
+ * @param per_job The amount of memory we expect a single job to need
+ */
+uint jobs_for_memory(const uint64_t & per_job) {
+    const long pages = sysconf(_SC_PHYS_PAGES);
+    const long page_size = sysconf(_SC_PAGE_SIZE);
+    if (pages <= 0 || page_size <= 0) {
+        // We don't know, so don't limit anything
+        return 0;
+    }
+    const uint64_t total = static_cast<uint64_t>(pages) * static_cast<uint64_t>(page_size);
+    return std::max<uint64_t>(1, total / per_job);
+}
+
+uint to_uint(const std::string & name, const std::string & value) {
+    std::size_t pos = 0;
+    long v = 0;
+    try {
+        v = std::stol(value, &pos);
+    } catch (std::exception &) {
+        pos = std::string::npos;
+    }
+    if (pos != value.size() || v < 0) {
+        throw Util::Exceptions::MesonException{"Option \"" + name +
+                                               "\" must be a non-negative integer, not \"" +
+                                               value + "\""};
+    }
+    return static_cast<uint>(v);
+}
+
+bool to_bool(const std::string & name, const std::string & value) {
+    if (value == "on" || value == "true") {
+        return true;
+    } else if (value == "off" || value == "false") {
+        return false;
+    }
+    throw Util::Exceptions::MesonException{"Option \"" + name +
+                                           "\" must be one of \"on\" or \"off\", not \"" +
+                                           value + "\""};
+}
+
+/// The options the backends read per target, the rest only apply to the whole build
+const std::set<std::string> PER_TARGET{"unity", "unity_size", "split_debug", "cpp_modules"};
+
+void set_option(BuiltinOptions & opts, const std::string & k, const std::string & v) {
+    if (k == "backend_max_links") {
+        opts.backend_max_links = to_uint(k, v);
+    } else if (k == "backend_max_archives") {
+        opts.backend_max_archives = to_uint(k, v);
+    } else if (k == "unity") {
+        opts.unity = to_bool(k, v);
+    } else if (k == "unity_size") {
+        opts.unity_size = to_uint(k, v);
+        if (opts.unity_size == 0) {
+            throw Util::Exceptions::MesonException{"Option \"unity_size\" must be at least 1"};
+        }
+    } else if (k == "split_debug") {
+        opts.split_debug = to_bool(k, v);
+    } else if (k == "cpp_modules") {
+        opts.cpp_modules = to_bool(k, v);
+    } else if (k == "cpp_launcher") {
+        opts.cpp_launcher = v.empty() ? "none" : v;
+    } else if (k == "cpp_ld") {
+        opts.cpp_ld = v;
+    } else {
+        throw Util::Exceptions::MesonException{"Unknown option \"" + k + "\""};
+    }
+}
+
+} // namespace
+
+// Links of large, debug or LTO targets can easily use several gigabytes each,
+// while archiving is cheap and mostly I/O bound.
+BuiltinOptions::BuiltinOptions()
+    : backend_max_links{jobs_for_memory(2ull << 30)},
+      backend_max_archives{jobs_for_memory(512ull << 20)}, unity{false}, unity_size{4},
+      cpp_launcher{"auto"}, cpp_ld{}, split_debug{false}, cpp_modules{false} {};
+
+std::map<std::string, std::string> get_options(const BuiltinOptions & opts) {
+    const auto from_bool = [](const bool & b) -> std::string { return b ? "true" : "false"; };
+    return {
+        {"backend_max_links", std::to_string(opts.backend_max_links)},
+        {"backend_max_archives", std::to_string(opts.backend_max_archives)},
+        {"unity", from_bool(opts.unity)},
+        {"unity_size", std::to_string(opts.unity_size)},
+        {"cpp_launcher", opts.cpp_launcher},
+        {"cpp_ld", opts.cpp_ld},
+        {"split_debug", from_bool(opts.split_debug)},
+        {"cpp_modules", from_bool(opts.cpp_modules)},
+    };
+}
+
+void set_options(BuiltinOptions & opts,
+                 const std::map<std::string, std::string> & values) {
+    for (const auto & [k, v] : values) {
+        set_option(opts, k, v);
+    }
+}
+
+BuiltinOptions override_options(const BuiltinOptions & opts,
+                                const std::map<std::string, std::string> & values) {
+    BuiltinOptions new_opts = opts;
+    for (const auto & [k, v] : values) {
+        // Unknown options and invalid values are reported the same way as globally
+        set_option(new_opts, k, v);
+        if (PER_TARGET.count(k) == 0) {
+            throw Util::Exceptions::InvalidArguments{"Option \"" + k +
+                                                     "\" cannot be overridden per target"};
+        }
+    }
+    return new_opts;
+}
+
+} // namespace MIR::State
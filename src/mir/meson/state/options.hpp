@@ -0,0 +1,87 @@
+// SPDX-license-identifier: Apache-2.0
+// Copyright © 2021 Intel Corporation
+
+/**
+ * Built-in options
+ */
+
+#pragma once
+
+#include <map>
+#include <string>
+
+namespace MIR::State {
+
+/**
+ * Options provided by Meson++ itself, rather than by the project
+ *
+ * These are set with `-D` on the command line.
+ */
+class BuiltinOptions {
+  public:
+    BuiltinOptions();
+    ~BuiltinOptions(){};
+
+    /// The maximum number of concurrent link steps, 0 means unlimited
+    uint backend_max_links;
+
+    /// The maximum number of concurrent archive steps, 0 means unlimited
+    uint backend_max_archives;
+
+    /// Whether to combine the sources of a target into unity (jumbo) files
+    bool unity;
+
+    /// The maximum number of sources combined into a single unity file
+    uint unity_size;
+
+    /**
+     * The program to wrap C++ compilation with
+     *
+     * "auto" looks for ccache or sccache, "none" disables the launcher, any
+     * other value is used as the launcher command.
+     */
+    std::string cpp_launcher;
+
+    /**
+     * The linker for the C++ compiler to use, passed as `-fuse-ld=`
+     *
+     * Such as "bfd", "gold", "lld", or "mold". Empty uses the `CXX_LD`
+     * environment variable if set, otherwise the compiler's default.
+     */
+    std::string cpp_ld;
+
+    /// Whether to put debug information in separate files, and index it at link time
+    bool split_debug;
+
+    /// Whether to scan C++ sources for C++20 module dependencies
+    bool cpp_modules;
+};
+
+/**
+ * Set built-in options from the raw values passed on the command line
+ *
+ * @throws Util::Exceptions::MesonException if an option is unknown, or a value is invalid
+ */
+void set_options(BuiltinOptions &, const std::map<std::string, std::string> &);
+
+/**
+ * Get the value of every built-in option, as it would be set on the command line
+ *
+ * Passing the result to `set_options` gives back the same options.
+ */
+std::map<std::string, std::string> get_options(const BuiltinOptions &);
+
+/**
+ * Apply per target overrides to the built-in options
+ *
+ * Only unity, unity_size, split_debug and cpp_modules can be overridden, the
+ * others only apply to the build as a whole.
+ *
+ * @returns A copy of the options with the overrides applied
+ * @throws Util::Exceptions::InvalidArguments if an option can't be overridden per target
+ * @throws Util::Exceptions::MesonException if an option is unknown, or a value is invalid
+ */
+BuiltinOptions override_options(const BuiltinOptions &,
+                                const std::map<std::string, std::string> &);
+
+} // namespace MIR::State
@@ -0,0 +1,449 @@
+// SPDX-license-identifier: Apache-2.0
+// Copyright © 2021 Intel Corporation
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <sstream>
+#include <sys/stat.h>
+#include <unordered_map>
+
+#include "exceptions.hpp"
+#include "hash.hpp"
+#include "io.hpp"
+#include "process.hpp"
+#include "serialize.hpp"
+#include "state/state.hpp"
+#include "toolchains/compilers/cpp/cpp.hpp"
+
+namespace fs = std::filesystem;
+
+namespace MIR::State {
+
+namespace {
+
+/// The file magic, the last byte is the version of the format
+constexpr std::array<char, 8> MAGIC{'M', 'P', 'P', 'S', 'T', 'A', '\0', 3};
+
+/// Stat a file, without hashing it
+std::optional<FileStamp> stamp(const fs::path & path) {
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) {
+        return std::nullopt;
+    }
+    return FileStamp{path, st.st_mtim.tv_sec * 1000000000ll + st.st_mtim.tv_nsec,
+                     static_cast<uint64_t>(st.st_size), 0};
+}
+
+bool same_stat(const FileStamp & a, const FileStamp & b) {
+    return a.path == b.path && a.mtime == b.mtime && a.size == b.size;
+}
+
+uint64_t hash_file(const fs::path & path) {
+    const Util::MappedFile file{path};
+    return Util::Hasher{}.add(file.contents()).digest();
+}
+
+uint64_t environment_hash() {
+    Util::Hasher hasher{};
+    for (const auto & name : ENVIRONMENT) {
+        const char * value = std::getenv(name.c_str());
+        // Unset and empty are different
+        hasher.add(name).add(value != nullptr ? 1 : 0).add(value != nullptr ? value : "");
+    }
+    return hasher.digest();
+}
+
+/**
+ * The linker a compiler driver runs, from the arguments used to select it
+ *
+ * Drivers search their own directories before PATH, so this only finds the
+ * linker that would be run if it isn't installed alongside the compiler.
+ */
+std::string linker_program(const std::vector<std::string> & select) {
+    const std::string prefix = "-fuse-ld=";
+    for (const auto & a : select) {
+        if (a.compare(0, prefix.size(), prefix) == 0) {
+            const auto name = a.substr(prefix.size());
+            // Clang also takes the path to a linker
+            return name.find('/') != std::string::npos ? name : "ld." + name;
+        }
+    }
+    return "ld";
+}
+
+/// Stat meson++ and the programs in each toolchain, found the way they are run
+std::vector<FileStamp> program_stamps(const Persistant & pstate) {
+    std::vector<fs::path> programs{pstate.program};
+    const auto add = [&](const std::vector<std::string> & cmd) {
+        if (cmd.empty()) {
+            return;
+        }
+        const auto found =
+            cmd[0].find('/') == std::string::npos ? Util::find_program(cmd[0]) : cmd[0];
+        if (!found.empty()) {
+            programs.emplace_back(found);
+        }
+    };
+    for (const auto & [_, tc] : pstate.toolchains) {
+        const auto & t = tc.build();
+        add(t->compiler->launcher);
+        add(t->compiler->command);
+        if (const auto * driver =
+                dynamic_cast<const Toolchain::Linker::Drivers::Gnu *>(t->linker.get());
+            driver != nullptr) {
+            add({linker_program(driver->selection())});
+        }
+        if (t->archiver != nullptr) {
+            add(t->archiver->command());
+        }
+    }
+
+    std::vector<FileStamp> stamps{};
+    for (const auto & p : programs) {
+        if (auto s = stamp(p); s.has_value()) {
+            stamps.emplace_back(std::move(s.value()));
+        }
+    }
+    return stamps;
+}
+
+/**
+ * Take the fingerprint of a configure
+ *
+ * Build files that haven't changed since the previous fingerprint keep their
+ * hash instead of being read again.
+ */
+Fingerprint take_fingerprint(const Persistant & pstate) {
+    std::unordered_map<std::string, const FileStamp *> previous{};
+    for (const auto & f : pstate.fingerprint.build_files) {
+        previous.emplace(f.path.string(), &f);
+    }
+
+    Fingerprint fp{{}, program_stamps(pstate), environment_hash()};
+    for (const auto & f : pstate.build_files) {
+        auto s = stamp(f);
+        if (!s.has_value()) {
+            // Never matches, so the next configure won't be skipped
+            fp.build_files.emplace_back(FileStamp{f, -1, 0, 0});
+            continue;
+        }
+        const auto prev = previous.find(f.string());
+        if (prev != previous.end() && same_stat(*prev->second, s.value())) {
+            s->hash = prev->second->hash;
+        } else {
+            s->hash = hash_file(f);
+        }
+        fp.build_files.emplace_back(std::move(s.value()));
+    }
+    return fp;
+}
+
+void write_stamps(std::ostream & out, const std::vector<FileStamp> & stamps) {
+    Util::write(out, static_cast<uint32_t>(stamps.size()));
+    for (const auto & s : stamps) {
+        Util::write(out, s.path.string());
+        Util::write(out, s.mtime);
+        Util::write(out, s.size);
+        Util::write(out, s.hash);
+    }
+}
+
+bool read_stamps(Util::Reader & reader, std::vector<FileStamp> & stamps) {
+    uint32_t count;
+    if (!reader.read(count)) {
+        return false;
+    }
+    for (uint32_t i = 0; i < count; ++i) {
+        std::string path;
+        FileStamp s{};
+        if (!reader.read(path) || !reader.read(s.mtime) || !reader.read(s.size) ||
+            !reader.read(s.hash)) {
+            return false;
+        }
+        s.path = path;
+        stamps.emplace_back(std::move(s));
+    }
+    return true;
+}
+
+void write_map(std::ostream & out, const std::map<std::string, std::string> & map) {
+    std::vector<std::string> flat{};
+    for (const auto & [k, v] : map) {
+        flat.emplace_back(k);
+        flat.emplace_back(v);
+    }
+    Util::write(out, flat);
+}
+
+bool read_map(Util::Reader & reader, std::map<std::string, std::string> & map) {
+    std::vector<std::string> flat{};
+    if (!reader.read(flat) || flat.size() % 2 != 0) {
+        return false;
+    }
+    for (std::size_t i = 0; i < flat.size(); i += 2) {
+        map.insert_or_assign(std::move(flat[i]), std::move(flat[i + 1]));
+    }
+    return true;
+}
+
+void write_info(std::ostream & out, const Machines::Info & info) {
+    Util::write(out, static_cast<uint8_t>(info.machine));
+    Util::write(out, static_cast<uint8_t>(info.kernel));
+    Util::write(out, static_cast<uint8_t>(info.endian));
+    Util::write(out, info.cpu_family);
+    Util::write(out, info.cpu);
+}
+
+std::optional<Machines::Info> read_info(Util::Reader & reader) {
+    uint8_t machine, kernel, endian;
+    std::string cpu_family, cpu;
+    if (!reader.read(machine) || !reader.read(kernel) || !reader.read(endian) ||
+        !reader.read(cpu_family) || !reader.read(cpu)) {
+        return std::nullopt;
+    }
+    return Machines::Info{static_cast<Machines::Machine>(machine),
+                          static_cast<Machines::Kernel>(kernel),
+                          static_cast<Machines::Endian>(endian), cpu_family, cpu};
+}
+
+/**
+ * Write a toolchain as the ids and commands of its tools
+ *
+ * That is all that detection finds out, so that is enough to create the same
+ * toolchain again without running anything.
+ */
+void write_toolchain(std::ostream & out, const Toolchain::Toolchain & tc) {
+    Util::write(out, tc.compiler->id());
+    Util::write(out, tc.compiler->command);
+    Util::write(out, tc.compiler->launcher);
+
+    // Linkers are only ever found through the compiler driving them
+    const auto * driver = dynamic_cast<const Toolchain::Linker::Drivers::Gnu *>(tc.linker.get());
+    if (driver == nullptr) {
+        throw Util::Exceptions::MesonException{"Cannot save the state of linker " +
+                                               tc.linker->id()};
+    }
+    Util::write(out, driver->id());
+    Util::write(out, driver->selection());
+
+    // An archiver may not have been found
+    Util::write(out, tc.archiver != nullptr ? tc.archiver->id() : "");
+    Util::write(out, tc.archiver != nullptr ? tc.archiver->command() : std::vector<std::string>{});
+    const auto * ar = dynamic_cast<const Toolchain::Archiver::Gnu *>(tc.archiver.get());
+    const auto thin = ar != nullptr ? ar->thin : Toolchain::Archiver::ThinArchives::NONE;
+    Util::write(out, static_cast<uint8_t>(thin));
+}
+
+std::unique_ptr<Toolchain::Compiler::Compiler>
+make_compiler(const Toolchain::Language & lang, const std::string & id,
+              const std::vector<std::string> & command, const std::vector<std::string> & launcher) {
+    switch (lang) {
+        case Toolchain::Language::CPP:
+            if (id == "gcc") {
+                return std::make_unique<Toolchain::Compiler::CPP::Gnu>(command, launcher);
+            } else if (id == "clang") {
+                return std::make_unique<Toolchain::Compiler::CPP::Clang>(command, launcher);
+            }
+            break;
+    }
+    return nullptr;
+}
+
+std::unique_ptr<Toolchain::Linker::Linker> make_linker(const std::string & id,
+                                                       const std::vector<std::string> & command) {
+    if (id == "ld.bfd") {
+        return std::make_unique<Toolchain::Linker::GnuBFD>(command);
+    } else if (id == "ld.gold") {
+        return std::make_unique<Toolchain::Linker::GnuGold>(command);
+    } else if (id == "ld.lld") {
+        return std::make_unique<Toolchain::Linker::LLD>(command);
+    } else if (id == "ld.mold") {
+        return std::make_unique<Toolchain::Linker::Mold>(command);
+    }
+    return nullptr;
+}
+
+std::shared_ptr<Toolchain::Toolchain> read_toolchain(Util::Reader & reader,
+                                                     const Toolchain::Language & lang) {
+    std::string compiler_id, linker_id, archiver_id;
+    std::vector<std::string> command, launcher, select, archiver_command;
+    uint8_t thin;
+    if (!reader.read(compiler_id) || !reader.read(command) || !reader.read(launcher) ||
+        !reader.read(linker_id) || !reader.read(select) || !reader.read(archiver_id) ||
+        !reader.read(archiver_command) || !reader.read(thin) ||
+        thin > static_cast<uint8_t>(Toolchain::Archiver::ThinArchives::OPTION)) {
+        return nullptr;
+    }
+
+    auto comp = make_compiler(lang, compiler_id, command, launcher);
+    if (comp == nullptr) {
+        return nullptr;
+    }
+
+    // The same command the linker was detected with
+    auto linker_command = comp->command;
+    linker_command.insert(linker_command.end(), select.begin(), select.end());
+    auto linker = make_linker(linker_id, linker_command);
+    if (linker == nullptr) {
+        return nullptr;
+    }
+
+    std::unique_ptr<Toolchain::Archiver::Archiver> archiver{nullptr};
+    if (archiver_id == "gnu") {
+        archiver = std::make_unique<Toolchain::Archiver::Gnu>(
+            archiver_command, static_cast<Toolchain::Archiver::ThinArchives>(thin));
+    } else if (!archiver_id.empty()) {
+        return nullptr;
+    }
+
+    const auto * c = comp.get();
+    return std::make_shared<Toolchain::Toolchain>(
+        std::move(comp),
+        std::make_unique<Toolchain::Linker::Drivers::Gnu>(std::move(linker), c, select),
+        std::move(archiver));
+}
+
+} // namespace
+
+void save(const Persistant & pstate) {
+    std::ostringstream out{};
+    out.write(MAGIC.data(), MAGIC.size());
+    Util::write(out, fs::absolute(pstate.source_root).lexically_normal().string());
+    Util::write(out, pstate.name);
+    Util::write(out, pstate.program.string());
+
+    std::vector<std::string> build_files{};
+    for (const auto & f : pstate.build_files) {
+        build_files.emplace_back(f.string());
+    }
+    Util::write(out, build_files);
+
+    write_map(out, pstate.cmdline_options);
+    write_map(out, get_options(pstate.options));
+
+    // XXX: Only the build machine exists until there are machine files
+    write_info(out, pstate.machines.build());
+    Util::write(out, static_cast<uint32_t>(pstate.toolchains.size()));
+    for (const auto & [lang, tc] : pstate.toolchains) {
+        Util::write(out, static_cast<uint8_t>(lang));
+        write_toolchain(out, *tc.build());
+    }
+
+    const auto fp = take_fingerprint(pstate);
+    write_stamps(out, fp.build_files);
+    write_stamps(out, fp.programs);
+    Util::write(out, fp.environment);
+
+    fs::create_directories(pstate.build_root);
+    Util::write_if_changed(pstate.build_root / STATE_FILE, out.str());
+}
+
+std::optional<Persistant> load(const fs::path & build_root) {
+    const Util::MappedFile file{build_root / STATE_FILE};
+    Util::Reader reader{file.contents()};
+
+    std::array<char, MAGIC.size()> magic;
+    if (!reader.read(magic) || magic != MAGIC) {
+        return std::nullopt;
+    }
+
+    std::string source_root, name, program;
+    std::vector<std::string> build_files{};
+    std::map<std::string, std::string> cmdline_options{}, options{};
+    if (!reader.read(source_root) || !reader.read(name) || !reader.read(program) ||
+        !reader.read(build_files) || !read_map(reader, cmdline_options) ||
+        !read_map(reader, options)) {
+        return std::nullopt;
+    }
+
+    auto info = read_info(reader);
+    if (!info.has_value()) {
+        return std::nullopt;
+    }
+
+    Persistant pstate{source_root, build_root,
+                      Machines::PerMachine<Machines::Info>{std::move(info.value())}};
+    pstate.name = name;
+    pstate.program = program;
+    pstate.build_files.assign(build_files.begin(), build_files.end());
+    pstate.cmdline_options = cmdline_options;
+    try {
+        set_options(pstate.options, options);
+    } catch (Util::Exceptions::MesonException &) {
+        // The options changed since the state was written
+        return std::nullopt;
+    }
+
+    uint32_t count;
+    if (!reader.read(count)) {
+        return std::nullopt;
+    }
+    for (uint32_t i = 0; i < count; ++i) {
+        uint8_t lang;
+        if (!reader.read(lang)) {
+            return std::nullopt;
+        }
+        const auto l = static_cast<Toolchain::Language>(lang);
+        auto tc = read_toolchain(reader, l);
+        if (tc == nullptr) {
+            return std::nullopt;
+        }
+        pstate.toolchains[l].set(Machines::Machine::BUILD, std::move(tc));
+    }
+
+    auto & fp = pstate.fingerprint;
+    if (!read_stamps(reader, fp.build_files) || !read_stamps(reader, fp.programs) ||
+        !reader.read(fp.environment) || !reader.done()) {
+        return std::nullopt;
+    }
+    return pstate;
+}
+
+bool toolchains_changed(const Persistant & pstate) {
+    const auto & fp = pstate.fingerprint;
+    const auto programs = program_stamps(pstate);
+    return fp.environment != environment_hash() ||
+           !std::equal(programs.begin(), programs.end(), fp.programs.begin(),
+                       fp.programs.end(), same_stat);
+}
+
+bool build_files_changed(const Fingerprint & fp) {
+    for (const auto & f : fp.build_files) {
+        const auto s = stamp(f.path);
+        if (!s.has_value()) {
+            return true;
+        }
+        if (same_stat(f, s.value())) {
+            continue;
+        }
+        // Touched, but maybe not changed, as happens with a checkout
+        if (s->size != f.size || hash_file(f.path) != f.hash) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool up_to_date(const Persistant & pstate, const std::map<std::string, std::string> & options) {
+    const auto & fp = pstate.fingerprint;
+    if (fp.build_files.empty()) {
+        // There hasn't been a configure
+        return false;
+    }
+
+    for (const auto & [k, v] : options) {
+        const auto found = pstate.cmdline_options.find(k);
+        if (found == pstate.cmdline_options.end() || found->second != v) {
+            return false;
+        }
+    }
+
+    if (toolchains_changed(pstate)) {
+        return false;
+    }
+
+    return !build_files_changed(fp);
+}
+
+} // namespace MIR::State
@@ -3,14 +3,49 @@
 
 #pragma once
 
+#include <cstdint>
 #include <filesystem>
-#include <unordered_map>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
 
 #include "machines.hpp"
+#include "state/options.hpp"
 #include "toolchains/toolchain.hpp"
 
 namespace MIR::State {
 
+/// Enough about a file to tell if it changed
+struct FileStamp {
+    std::filesystem::path path;
+
+    /// The modification time, in nanoseconds
+    int64_t mtime;
+
+    uint64_t size;
+
+    /// A hash of the contents, or 0 if only the size and time are compared
+    uint64_t hash;
+};
+
+/**
+ * Everything outside of the build directory that a configure depended on
+ *
+ * If none of this changed, and the same options are passed, configuring
+ * again would write exactly the same files.
+ */
+struct Fingerprint {
+    /// Every build definition file read
+    std::vector<FileStamp> build_files;
+
+    /// Meson++ itself and the toolchain programs, only compared by size and time
+    std::vector<FileStamp> programs;
+
+    /// A hash of the environment variables read while detecting toolchains
+    uint64_t environment;
+};
+
 /**
  * Persistant state
  *
@@ -19,13 +54,23 @@ namespace MIR::State {
 class Persistant {
   public:
     Persistant(const std::filesystem::path & sr_, const std::filesystem::path & br_)
-        : toolchains{}, machines{Machines::detect_build()}, source_root{sr_}, build_root{br_} {};
+        : toolchains{}, machines{Machines::detect_build()}, options{}, source_root{sr_},
+          build_root{br_}, build_files{}, program{}, cmdline_options{}, fingerprint{} {};
+    Persistant(const std::filesystem::path & sr_, const std::filesystem::path & br_,
+               Machines::PerMachine<Machines::Info> && m)
+        : toolchains{}, machines{std::move(m)}, options{}, source_root{sr_}, build_root{br_},
+          build_files{}, program{}, cmdline_options{}, fingerprint{} {};
+    Persistant(Persistant &&) = default;
     ~Persistant(){};
 
     // This must be mutable because of `add_language`
-    /// A mapping of language : machine : toolchain
-    std::unordered_map<Toolchain::Language,
-                       Machines::PerMachine<std::shared_ptr<Toolchain::Toolchain>>>
+    /**
+     * A mapping of language : machine : toolchain
+     *
+     * This is ordered so that everything generated from it is the same on
+     * every run.
+     */
+    std::map<Toolchain::Language, Machines::PerMachine<std::shared_ptr<Toolchain::Toolchain>>>
         toolchains;
 
     /// The information on each machine
@@ -33,6 +78,9 @@ class Persistant {
     /// a machine file
     Machines::PerMachine<Machines::Info> machines;
 
+    /// Built-in options
+    BuiltinOptions options;
+
     /// absolute path to the source tree
     const std::filesystem::path source_root;
 
@@ -41,6 +89,69 @@ class Persistant {
 
     /// The name of the project
     std::string name;
+
+    /// Every build definition file (meson.build) read by the frontend
+    std::vector<std::filesystem::path> build_files;
+
+    /// absolute path to the meson++ executable, to regenerate with
+    std::filesystem::path program;
+
+    /// The raw options passed on the command line, to be passed again when regenerating
+    std::map<std::string, std::string> cmdline_options;
+
+    /// What the last configure depended on, as loaded by `load`
+    Fingerprint fingerprint;
 };
 
+/// The name of the file the state is saved to, in the build directory
+inline const std::string STATE_FILE = ".meson++.state";
+
+/// The environment variables read while detecting toolchains
+inline const std::vector<std::string> ENVIRONMENT{"CXX", "CXX_LD", "PATH"};
+
+/**
+ * Write the persistant state into the build directory
+ *
+ * The state is written in a flat binary format, which is read straight out
+ * of a memory mapping, so that later runs don't need to detect toolchains or
+ * machines again. The fingerprint of the configure is taken at the same time,
+ * only hashing the build files that changed since the last fingerprint.
+ */
+void save(const Persistant & pstate);
+
+/**
+ * Read the persistant state written by the last configure
+ *
+ * @param build_root The build directory to read from
+ * @returns The state, or std::nullopt if there isn't one, or it was written by
+ *          an incompatible version of Meson++
+ */
+std::optional<Persistant> load(const std::filesystem::path & build_root);
+
+/**
+ * Check if the toolchains of the last configure could be found differently now
+ *
+ * That is if the environment variables read while detecting them, or the
+ * programs themselves, have changed since the fingerprint was taken.
+ */
+bool toolchains_changed(const Persistant & pstate);
+
+/**
+ * Check if any build file changed since the fingerprint was taken
+ *
+ * Files with the same size and modification time are not read.
+ */
+bool build_files_changed(const Fingerprint & fp);
+
+/**
+ * Check if configuring again would give the same result as the last configure
+ *
+ * Build files with the same size and modification time as in the fingerprint
+ * are assumed to be unchanged without reading them, others are hashed.
+ *
+ * @param pstate The loaded state, with the program that is running now
+ * @param options The options passed on the command line this time
+ */
+bool up_to_date(const Persistant & pstate, const std::map<std::string, std::string> & options);
+
 } // namespace MIR::State
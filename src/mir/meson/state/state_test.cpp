@@ -0,0 +1,171 @@
+// SPDX-license-identifier: Apache-2.0
+// Copyright © 2021 Intel Corporation
+
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+
+#include "state/state.hpp"
+#include "tempdir.hpp"
+#include "toolchains/compilers/cpp/cpp.hpp"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+class StateTest : public ::testing::Test {
+  protected:
+    void SetUp() override {
+        fs::create_directories(build / "src" / "sub");
+        std::ofstream{build / "src" / "meson.build"} << "project('p', 'cpp')\nsubdir('sub')\n";
+        std::ofstream{build / "src" / "sub" / "meson.build"} << "x = 1\n";
+    }
+
+    MIR::State::Persistant make_state() const {
+        namespace Toolchain = MIR::Toolchain;
+
+        MIR::State::Persistant pstate{"/src", build};
+        pstate.name = "project";
+        pstate.program = "/usr/bin/meson++";
+        pstate.build_files = {build / "src" / "meson.build", build / "src" / "sub" / "meson.build"};
+        pstate.cmdline_options = {{"cpp_ld", "gold"}, {"unity", "on"}};
+        MIR::State::set_options(pstate.options, pstate.cmdline_options);
+
+        auto comp = std::make_unique<Toolchain::Compiler::CPP::Gnu>(
+            std::vector<std::string>{"g++"}, std::vector<std::string>{"ccache"});
+        const auto * c = comp.get();
+        const std::vector<std::string> select{"-fuse-ld=gold"};
+        pstate.toolchains[Toolchain::Language::CPP].set(
+            MIR::Machines::Machine::BUILD,
+            std::make_shared<Toolchain::Toolchain>(
+                std::move(comp),
+                std::make_unique<Toolchain::Linker::Drivers::Gnu>(
+                    std::make_unique<Toolchain::Linker::GnuGold>(
+                        std::vector<std::string>{"g++", "-fuse-ld=gold"}),
+                    c, select),
+                std::make_unique<Toolchain::Archiver::Gnu>(
+                    std::vector<std::string>{"ar"}, Toolchain::Archiver::ThinArchives::MODIFIER)));
+        return pstate;
+    }
+
+    const Util::TempDir tmp{"meson++-state-test"};
+    const fs::path & build = tmp.path();
+};
+
+} // namespace
+
+TEST_F(StateTest, round_trip) {
+    const auto pstate = make_state();
+    MIR::State::save(pstate);
+
+    const auto loaded = MIR::State::load(build);
+    ASSERT_TRUE(loaded.has_value());
+    ASSERT_EQ(loaded->source_root, "/src");
+    ASSERT_EQ(loaded->build_root, build);
+    ASSERT_EQ(loaded->name, "project");
+    ASSERT_EQ(loaded->program, "/usr/bin/meson++");
+    ASSERT_EQ(loaded->build_files, pstate.build_files);
+    ASSERT_EQ(loaded->cmdline_options, pstate.cmdline_options);
+    ASSERT_EQ(MIR::State::get_options(loaded->options), MIR::State::get_options(pstate.options));
+    ASSERT_EQ(loaded->machines.build().cpu_family, pstate.machines.build().cpu_family);
+
+    const auto & tc = loaded->toolchains.at(MIR::Toolchain::Language::CPP).build();
+    ASSERT_NE(tc, nullptr);
+    ASSERT_EQ(tc->compiler->id(), "gcc");
+    ASSERT_EQ(tc->compiler->command, std::vector<std::string>{"g++"});
+    ASSERT_EQ(tc->compiler->launcher, std::vector<std::string>{"ccache"});
+    ASSERT_EQ(tc->linker->id(), "ld.gold");
+    ASSERT_EQ(tc->linker->command(), std::vector<std::string>{"g++"});
+    ASSERT_EQ(tc->linker->always_args(),
+              pstate.toolchains.at(MIR::Toolchain::Language::CPP).build()->linker->always_args());
+    ASSERT_EQ(tc->archiver->id(), "gnu");
+    ASSERT_EQ(tc->archiver->command(), std::vector<std::string>{"ar"});
+    ASSERT_EQ(tc->archiver->thin_args(), std::vector<std::string>{"csrDT"});
+}
+
+TEST_F(StateTest, missing) { ASSERT_FALSE(MIR::State::load(build).has_value()); }
+
+TEST_F(StateTest, corrupt) {
+    MIR::State::save(make_state());
+    const auto path = build / ".meson++.state";
+
+    // Truncated
+    fs::resize_file(path, fs::file_size(path) - 1);
+    ASSERT_FALSE(MIR::State::load(build).has_value());
+
+    // A different version of the format
+    std::ofstream{path, std::ios::binary} << std::string{"MPPSTA\0\2", 8};
+    ASSERT_FALSE(MIR::State::load(build).has_value());
+}
+
+TEST_F(StateTest, up_to_date) {
+    MIR::State::save(make_state());
+    const auto loaded = MIR::State::load(build);
+    ASSERT_TRUE(loaded.has_value());
+
+    ASSERT_TRUE(MIR::State::up_to_date(loaded.value(), {}));
+    ASSERT_TRUE(MIR::State::up_to_date(loaded.value(), {{"unity", "on"}}));
+    ASSERT_FALSE(MIR::State::up_to_date(loaded.value(), {{"unity", "off"}}));
+    ASSERT_FALSE(MIR::State::up_to_date(loaded.value(), {{"split_debug", "true"}}));
+    ASSERT_FALSE(MIR::State::toolchains_changed(loaded.value()));
+}
+
+TEST_F(StateTest, up_to_date_touched) {
+    MIR::State::save(make_state());
+    const auto file = build / "src" / "sub" / "meson.build";
+
+    // The same contents with a new modification time is still up to date
+    fs::last_write_time(file, fs::last_write_time(file) + std::chrono::seconds{5});
+    ASSERT_TRUE(MIR::State::up_to_date(MIR::State::load(build).value(), {}));
+
+    std::ofstream{file} << "x = 2\n";
+    ASSERT_FALSE(MIR::State::up_to_date(MIR::State::load(build).value(), {}));
+
+    fs::remove(file);
+    ASSERT_FALSE(MIR::State::up_to_date(MIR::State::load(build).value(), {}));
+}
+
+TEST_F(StateTest, up_to_date_environment) {
+    const char * old = std::getenv("CXX_LD");
+    const std::string saved = old != nullptr ? old : "";
+    unsetenv("CXX_LD");
+    MIR::State::save(make_state());
+
+    setenv("CXX_LD", "gold", 1);
+    const auto loaded = MIR::State::load(build);
+    ASSERT_FALSE(MIR::State::up_to_date(loaded.value(), {}));
+    ASSERT_TRUE(MIR::State::toolchains_changed(loaded.value()));
+
+    if (old != nullptr) {
+        setenv("CXX_LD", saved.c_str(), 1);
+    } else {
+        unsetenv("CXX_LD");
+    }
+}
+
+TEST_F(StateTest, up_to_date_linker) {
+    const char * old = std::getenv("PATH");
+    const std::string saved = old != nullptr ? old : "";
+    const auto bin = build / "bin";
+    fs::create_directories(bin);
+    setenv("PATH", bin.c_str(), 1);
+
+    // Only the linker selected with -fuse-ld=gold is found
+    const auto gold = bin / "ld.gold";
+    std::ofstream{gold} << "#!/bin/sh\n";
+    fs::permissions(gold, fs::perms::owner_all);
+    MIR::State::save(make_state());
+    ASSERT_TRUE(MIR::State::up_to_date(MIR::State::load(build).value(), {}));
+
+    std::ofstream{gold} << "#!/bin/sh\nexit 0\n";
+    const auto loaded = MIR::State::load(build);
+    ASSERT_FALSE(MIR::State::up_to_date(loaded.value(), {}));
+    ASSERT_TRUE(MIR::State::toolchains_changed(loaded.value()));
+
+    fs::remove(gold);
+    ASSERT_FALSE(MIR::State::up_to_date(MIR::State::load(build).value(), {}));
+
+    setenv("PATH", saved.c_str(), 1);
+}
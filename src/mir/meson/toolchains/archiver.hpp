@@ -35,24 +35,52 @@ class Archiver {
     /// Arguments that should always be used by this langauge/compiler
     virtual std::vector<std::string> always_args() const = 0;
 
+    /**
+     * Arguments to create a thin archive, used instead of `always_args`
+     *
+     * A thin archive references the object files by path instead of copying
+     * them in, so it is only usable while the objects exist. This makes it
+     * unsuitable for installing, but much cheaper to create.
+     *
+     * @returns The arguments, or an empty vector if thin archives aren't supported
+     */
+    virtual std::vector<std::string> thin_args() const = 0;
+
   protected:
     Archiver(const std::vector<std::string> & c) : _command{c} {};
 
     const std::vector<std::string> _command;
 };
 
+/**
+ * How an archiver is asked for a thin archive
+ */
+enum class ThinArchives {
+    /// Thin archives aren't supported
+    NONE,
+    /// The `T` modifier, deprecated in GNU ar 2.38
+    MODIFIER,
+    /// The `--thin` option, added in GNU ar 2.38
+    OPTION,
+};
+
 /**
  * The GNU ar archiver.
  */
 class Gnu : public Archiver {
   public:
-    Gnu(const std::vector<std::string> & c) : Archiver{c} {};
+    Gnu(const std::vector<std::string> & c, const ThinArchives & t = ThinArchives::NONE)
+        : Archiver{c}, thin{t} {};
     ~Gnu(){};
 
     RSPFileSupport rsp_support() const override;
     std::string id() const override { return "gnu"; }
     std::vector<std::string> command() const final;
     std::vector<std::string> always_args() const final;
+    std::vector<std::string> thin_args() const final;
+
+    /// Which form of thin archives this version of ar supports
+    const ThinArchives thin;
 };
 
 /**
@@ -14,4 +14,16 @@ std::vector<std::string> Gnu::always_args() const {
     return {"csrD"};
 }
 
+std::vector<std::string> Gnu::thin_args() const {
+    switch (thin) {
+        case ThinArchives::OPTION:
+            return {"--thin", "csrD"};
+        case ThinArchives::MODIFIER:
+            return {"csrDT"};
+        case ThinArchives::NONE:
+            break;
+    }
+    return {};
+}
+
 } // namespace MIR::Toolchain::Archiver
@@ -41,6 +41,71 @@ class Compiler {
      */
     virtual std::vector<std::string> output_command(const std::string & outfile) const = 0;
 
+    /**
+     * Get the command line arguments to write a Makefile style dependency file
+     *
+     * @param target The name of the target the dependencies are for
+     * @param depfile The name of the dependency file to write
+     */
+    virtual std::vector<std::string> generate_depfile(const std::string & target,
+                                                      const std::string & depfile) const = 0;
+
+    /// Get the command line arguments to compile a header into a precompiled header
+    virtual std::vector<std::string> precompile_header_command() const = 0;
+
+    /**
+     * Get the command line arguments to use a precompiled header
+     *
+     * @param header The path to the header that was precompiled, as if it lived
+     *               next to the precompiled header
+     */
+    virtual std::vector<std::string> use_pch_command(const std::string & header) const = 0;
+
+    /// The suffix added to the name of a header to get the name of its precompiled header
+    virtual std::string pch_suffix() const = 0;
+
+    /**
+     * Get the command line arguments to put debug information in a separate file
+     *
+     * These turn on debug information as well, as without it no separate file
+     * is written, and the build would never see it as up to date.
+     */
+    virtual std::vector<std::string> split_debug_args() const = 0;
+
+    /**
+     * Get the name of the separate debug file written alongside an object
+     *
+     * @param obj The name of the object file
+     */
+    virtual std::string split_debug_output(const std::string & obj) const = 0;
+
+    /**
+     * Get the program to run the module scan with, if it isn't the compiler itself
+     *
+     * @param ddi The P1689 module dependency file to write
+     */
+    virtual std::vector<std::string> module_scan_wrapper(const std::string & ddi) const = 0;
+
+    /**
+     * Get the command line arguments to scan a source for module dependencies
+     *
+     * These are passed to the compiler along with the same arguments used to
+     * compile the source, the source itself is added last.
+     *
+     * @param obj The object the source will be compiled into
+     * @param ddi The P1689 module dependency file to write
+     */
+    virtual std::vector<std::string> module_scan_args(const std::string & obj,
+                                                      const std::string & ddi) const = 0;
+
+    /**
+     * Get the command line arguments to compile with modules
+     *
+     * @param map The file mapping module names to their compiled interfaces,
+     *            written when the scan results are collated
+     */
+    virtual std::vector<std::string> module_map_args(const std::string & map) const = 0;
+
     /**
      * Convert a compiler specific argument into a generic one
      *
@@ -58,11 +123,29 @@ class Compiler {
     /// Command to invoke this compiler, as a vector
     const std::vector<std::string> command;
 
+    /**
+     * A program to wrap compilation with, such as ccache
+     *
+     * This is only used for compiling, never when the compiler is used as a
+     * linker driver.
+     */
+    const std::vector<std::string> launcher;
+
   protected:
-    Compiler(const std::vector<std::string> & c) : command{c} {};
+    Compiler(const std::vector<std::string> & c, const std::vector<std::string> & l)
+        : command{c}, launcher{l} {};
 };
 
+/**
+ * Find a working compiler
+ *
+ * @param bins The programs to try, in order
+ * @param launcher A program to wrap compilation with, such as ccache
+ * @param args Arguments that are part of the compiler command, like `-m32`
+ */
 std::unique_ptr<Compiler> detect_compiler(const Language &, const Machines::Machine &,
-                                          const std::vector<std::string> & bins = {});
+                                          const std::vector<std::string> & bins = {},
+                                          const std::vector<std::string> & launcher = {},
+                                          const std::vector<std::string> & args = {});
 
 } // namespace MIR::Toolchain::Compiler
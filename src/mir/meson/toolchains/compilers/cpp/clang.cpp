@@ -3,4 +3,22 @@
 
 #include "toolchains/compilers/cpp/cpp.hpp"
 
-namespace MIR::Toolchain::Compiler::CPP {} // namespace MIR::Toolchain::Compiler::CPP
+namespace MIR::Toolchain::Compiler::CPP {
+
+// TODO: find the clang-scan-deps matching the compiler, rather than the one in the PATH
+std::vector<std::string> Clang::module_scan_wrapper(const std::string & ddi) const {
+    return {"clang-scan-deps", "-format=p1689", "-o", ddi, "--"};
+}
+
+std::vector<std::string> Clang::module_scan_args(const std::string & obj,
+                                                 const std::string & ddi) const {
+    return {"-c", "-o", obj};
+}
+
+// The map is a response file of -fmodule-file= arguments. Interfaces are
+// written next to their objects, with a .pcm extension.
+std::vector<std::string> Clang::module_map_args(const std::string & map) const {
+    return {"-fmodule-output", "@" + map};
+}
+
+} // namespace MIR::Toolchain::Compiler::CPP
@@ -16,30 +16,48 @@ class GnuLike : public Compiler {
     RSPFileSupport rsp_support() const final;
     std::vector<std::string> compile_only_command() const final;
     std::vector<std::string> output_command(const std::string &) const final;
+    std::vector<std::string> generate_depfile(const std::string &,
+                                              const std::string &) const final;
+    std::vector<std::string> precompile_header_command() const final;
+    std::vector<std::string> use_pch_command(const std::string &) const final;
+    std::string pch_suffix() const final { return ".gch"; };
+    std::vector<std::string> split_debug_args() const final;
+    std::string split_debug_output(const std::string &) const final;
     Arguments::Argument generalize_argument(const std::string &) const final;
     std::string specialize_argument(const Arguments::Argument & arg) const final;
     std::vector<std::string> always_args() const final;
 
   protected:
-    GnuLike(const std::vector<std::string> & c) : Compiler{c} {};
+    GnuLike(const std::vector<std::string> & c, const std::vector<std::string> & l)
+        : Compiler{c, l} {};
 };
 
 class Gnu : public GnuLike {
   public:
-    Gnu(const std::vector<std::string> & c) : GnuLike{c} {};
+    Gnu(const std::vector<std::string> & c, const std::vector<std::string> & l = {})
+        : GnuLike{c, l} {};
     ~Gnu(){};
 
     std::string id() const override { return "gcc"; };
     std::string language() const override { return "C++"; };
+    std::vector<std::string> module_scan_wrapper(const std::string &) const final { return {}; };
+    std::vector<std::string> module_scan_args(const std::string &,
+                                              const std::string &) const final;
+    std::vector<std::string> module_map_args(const std::string &) const final;
 };
 
 class Clang : public GnuLike {
   public:
-    Clang(const std::vector<std::string> & c) : GnuLike{c} {};
+    Clang(const std::vector<std::string> & c, const std::vector<std::string> & l = {})
+        : GnuLike{c, l} {};
     ~Clang(){};
 
     std::string id() const override { return "clang"; };
     std::string language() const override { return "C++"; };
+    std::vector<std::string> module_scan_wrapper(const std::string &) const final;
+    std::vector<std::string> module_scan_args(const std::string &,
+                                              const std::string &) const final;
+    std::vector<std::string> module_map_args(const std::string &) const final;
 };
 
 } // namespace MIR::Toolchain::Compiler::CPP
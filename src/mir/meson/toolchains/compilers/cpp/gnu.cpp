@@ -3,4 +3,25 @@
 
 #include "toolchains/compilers/cpp/cpp.hpp"
 
-namespace MIR::Toolchain::Compiler::CPP {} // namespace MIR::Toolchain::Compiler::CPP
+namespace MIR::Toolchain::Compiler::CPP {
+
+// GCC 14 and later can write P1689 while preprocessing, the preprocessed
+// output itself isn't needed.
+std::vector<std::string> Gnu::module_scan_args(const std::string & obj,
+                                               const std::string & ddi) const {
+    return {"-E",
+            "-fmodules-ts",
+            "-fdeps-format=p1689r5",
+            "-fdeps-file=" + ddi,
+            "-fdeps-target=" + obj,
+            "-o",
+            "/dev/null"};
+}
+
+// The ordering between interfaces is handled by ninja's dyndep, so GCC
+// doesn't need to add them to the depfile.
+std::vector<std::string> Gnu::module_map_args(const std::string & map) const {
+    return {"-fmodules-ts", "-fmodule-mapper=" + map, "-Mno-modules"};
+}
+
+} // namespace MIR::Toolchain::Compiler::CPP
@@ -1,6 +1,8 @@
 // SPDX-license-identifier: Apache-2.0
 // Copyright © 2021 Intel Corporation
 
+#include <filesystem>
+
 #include "toolchains/compilers/cpp/cpp.hpp"
 
 namespace MIR::Toolchain::Compiler::CPP {
@@ -10,6 +12,25 @@ std::vector<std::string> GnuLike::output_command(const std::string & output) con
     return {"-o", output};
 }
 std::vector<std::string> GnuLike::compile_only_command() const { return {"-c"}; }
+std::vector<std::string> GnuLike::generate_depfile(const std::string & target,
+                                                   const std::string & depfile) const {
+    return {"-MD", "-MQ", target, "-MF", depfile};
+}
+std::vector<std::string> GnuLike::precompile_header_command() const {
+    return {"-x", "c++-header"};
+}
+
+// Both GCC and Clang look for `<header>.gch` when a header is force included,
+// and will use it if it's valid
+std::vector<std::string> GnuLike::use_pch_command(const std::string & header) const {
+    return {"-include", header, "-Winvalid-pch"};
+}
+// Since Clang 12 -gsplit-dwarf alone no longer enables debug information
+std::vector<std::string> GnuLike::split_debug_args() const { return {"-g", "-gsplit-dwarf"}; }
+std::string GnuLike::split_debug_output(const std::string & obj) const {
+    // The .dwo replaces the extension of the object, so foo.cpp.o gets foo.cpp.dwo
+    return std::filesystem::path{obj}.replace_extension(".dwo").string();
+}
 
 Arguments::Argument GnuLike::generalize_argument(const std::string & arg) const {
     if (arg.substr(0, 2) == "-L") {
@@ -6,6 +6,7 @@
  */
 
 #include <cassert>
+#include <cstdio>
 #include <memory>
 #include <string>
 #include <vector>
@@ -19,8 +20,30 @@ namespace {
 
 const std::vector<std::string> DEFAULT{"ar"};
 
+/**
+ * Work out how thin archives are made from the output of `ar --version`
+ *
+ * The first line ends with the binutils version, like
+ * "GNU ar (GNU Binutils for Debian) 2.40".
+ */
+ThinArchives gnu_thin_archives(const std::string & version) {
+    const auto line = version.substr(0, version.find('\n'));
+    const auto start = line.find_last_of(' ');
+    unsigned major = 0, minor = 0;
+    if (start == std::string::npos ||
+        std::sscanf(line.c_str() + start + 1, "%u.%u", &major, &minor) != 2) {
+        return ThinArchives::NONE;
+    }
+    if (major > 2 || (major == 2 && minor >= 38)) {
+        return ThinArchives::OPTION;
+    } else if (major == 2 && minor >= 19) {
+        return ThinArchives::MODIFIER;
+    }
+    return ThinArchives::NONE;
 }
 
+} // namespace
+
 std::unique_ptr<Archiver> detect_archiver(const Machines::Machine & machine,
                                           const std::vector<std::string> & bins) {
     // TODO: handle the machine switch, and the cross/native file
@@ -31,7 +54,7 @@ std::unique_ptr<Archiver> detect_archiver(const Machines::Machine & machine,
         }
 
         if (out.find("Free Software Foundation") != std::string::npos) {
-            return std::make_unique<Gnu>(std::vector<std::string>{c});
+            return std::make_unique<Gnu>(std::vector<std::string>{c}, gnu_thin_archives(out));
         }
     }
     return nullptr;
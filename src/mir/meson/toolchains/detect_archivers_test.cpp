@@ -4,8 +4,31 @@
 
 #include <gtest/gtest.h>
 
+#include <filesystem>
+#include <fstream>
+#include <unistd.h>
+
 #include "archiver.hpp"
 
+namespace {
+
+/// Detect a fake ar, which reports the given binutils version
+std::vector<std::string> thin_args_for(const std::string & version) {
+    const auto ar = std::filesystem::temp_directory_path() /
+                    ("meson++-fake-ar-" + std::to_string(getpid()));
+    std::ofstream{ar} << "#!/bin/sh\n"
+                      << "echo 'GNU ar (GNU Binutils) " << version << "'\n"
+                      << "echo 'Copyright (C) 2022 Free Software Foundation, Inc.'\n";
+    std::filesystem::permissions(ar, std::filesystem::perms::owner_all);
+
+    const auto comp =
+        MIR::Toolchain::Archiver::detect_archiver(MIR::Machines::Machine::BUILD, {ar});
+    std::filesystem::remove(ar);
+    return comp != nullptr ? comp->thin_args() : std::vector<std::string>{"not found"};
+}
+
+} // namespace
+
 TEST(detect_archivers, gnu) {
     // TODO: there are multiple binaries called ar, how can we be sure we're
     // getting the one we expect?
@@ -19,3 +42,11 @@ TEST(detect_archivers, gnu) {
     ASSERT_NE(comp, nullptr);
     ASSERT_EQ(comp->id(), "gnu");
 }
+
+TEST(detect_archivers, thin) {
+    ASSERT_EQ(thin_args_for("2.40"), (std::vector<std::string>{"--thin", "csrD"}));
+    ASSERT_EQ(thin_args_for("2.38"), (std::vector<std::string>{"--thin", "csrD"}));
+    ASSERT_EQ(thin_args_for("2.35.2"), std::vector<std::string>{"csrDT"});
+    ASSERT_EQ(thin_args_for("2.18"), std::vector<std::string>{});
+    ASSERT_EQ(thin_args_for("unknown"), std::vector<std::string>{});
+}
@@ -20,18 +20,25 @@ namespace {
 const std::vector<std::string> DEFAULT_CPP{"c++", "g++", "clang++"};
 
 std::unique_ptr<Compiler> detect_cpp_compiler(const Machines::Machine & m,
-                                              const std::vector<std::string> & bins) {
+                                              const std::vector<std::string> & bins,
+                                              const std::vector<std::string> & launcher,
+                                              const std::vector<std::string> & args) {
     // TODO: handle the machine switch, and the cross/native file
     for (const auto & c : bins) {
-        auto const & [ret, out, err] = Util::process(std::vector<std::string>{c, "--version"});
+        std::vector<std::string> command{c};
+        command.insert(command.end(), args.begin(), args.end());
+
+        auto version_command = command;
+        version_command.emplace_back("--version");
+        auto const & [ret, out, err] = Util::process(version_command);
         if (ret != 0) {
             continue;
         }
 
         if (out.find("Free Software Foundation") != std::string::npos) {
-            return std::make_unique<CPP::Gnu>(std::vector<std::string>{c});
+            return std::make_unique<CPP::Gnu>(command, launcher);
         } else if (out.find("clang version") != std::string::npos) {
-            return std::make_unique<CPP::Clang>(std::vector<std::string>{c});
+            return std::make_unique<CPP::Clang>(command, launcher);
         }
     }
     return nullptr;
@@ -40,10 +47,13 @@ std::unique_ptr<Compiler> detect_cpp_compiler(const Machines::Machine & m,
 } // namespace
 
 std::unique_ptr<Compiler> detect_compiler(const Language & lang, const Machines::Machine & machine,
-                                          const std::vector<std::string> & bins) {
+                                          const std::vector<std::string> & bins,
+                                          const std::vector<std::string> & launcher,
+                                          const std::vector<std::string> & args) {
     switch (lang) {
         case Language::CPP:
-            return detect_cpp_compiler(machine, bins.empty() ? DEFAULT_CPP : bins);
+            return detect_cpp_compiler(machine, bins.empty() ? DEFAULT_CPP : bins, launcher,
+                                       args);
     }
     assert(false);
 };
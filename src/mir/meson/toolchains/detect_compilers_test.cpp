@@ -5,6 +5,7 @@
 #include <gtest/gtest.h>
 
 #include "compiler.hpp"
+#include "toolchain.hpp"
 
 TEST(detect_compilers, g_plus_plus) {
     // Skip if we don't have g++
@@ -27,3 +28,43 @@ TEST(detect_compilers, clang_plus_plus) {
     ASSERT_NE(comp, nullptr);
     ASSERT_EQ(comp->id(), "clang");
 }
+
+TEST(detect_compilers, launcher) {
+    // Skip if we don't have g++
+    if (system("g++") == 127) {
+        GTEST_SKIP();
+    }
+    const auto comp = MIR::Toolchain::Compiler::detect_compiler(
+        MIR::Toolchain::Language::CPP, MIR::Machines::Machine::BUILD, {"g++"}, {"ccache"});
+    ASSERT_NE(comp, nullptr);
+    ASSERT_EQ(comp->command, std::vector<std::string>{"g++"});
+    ASSERT_EQ(comp->launcher, std::vector<std::string>{"ccache"});
+}
+
+TEST(detect_compilers, launcher_from_env) {
+    // Skip if we don't have g++
+    if (system("g++") == 127) {
+        GTEST_SKIP();
+    }
+    setenv("CXX", "ccache g++", 1);
+    const auto tc = MIR::Toolchain::get_toolchain(MIR::Toolchain::Language::CPP,
+                                                  MIR::Machines::Machine::BUILD, "auto");
+    unsetenv("CXX");
+    ASSERT_NE(tc.compiler, nullptr);
+    ASSERT_EQ(tc.compiler->command, std::vector<std::string>{"g++"});
+    ASSERT_EQ(tc.compiler->launcher, std::vector<std::string>{"ccache"});
+}
+
+TEST(detect_compilers, arguments_from_env) {
+    // Skip if we don't have g++
+    if (system("g++") == 127) {
+        GTEST_SKIP();
+    }
+    setenv("CXX", "ccache g++ -m32 -O1", 1);
+    const auto tc = MIR::Toolchain::get_toolchain(MIR::Toolchain::Language::CPP,
+                                                  MIR::Machines::Machine::BUILD, "auto");
+    unsetenv("CXX");
+    ASSERT_NE(tc.compiler, nullptr);
+    ASSERT_EQ(tc.compiler->command, (std::vector<std::string>{"g++", "-m32", "-O1"}));
+    ASSERT_EQ(tc.compiler->launcher, std::vector<std::string>{"ccache"});
+}
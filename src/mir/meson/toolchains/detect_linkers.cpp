@@ -5,7 +5,6 @@
  * Linker detection functions
  */
 
-#include <cassert>
 #include <memory>
 #include <string>
 #include <vector>
@@ -20,33 +19,55 @@ namespace MIR::Toolchain::Linker {
 namespace {
 
 /**
- * Specialization for GCC (and G++, etc)
+ * Specialization for GCC compatible drivers (gcc, g++, clang, clang++)
  */
-std::unique_ptr<Linker> detect_linker_gcc(const std::unique_ptr<Compiler::Compiler> & comp,
-                                          const Machines::Machine & machine) {
+std::unique_ptr<Linker> detect_linker_gnu_driver(const std::unique_ptr<Compiler::Compiler> & comp,
+                                                 const Machines::Machine & machine,
+                                                 const std::string & name) {
+    std::vector<std::string> select{};
+    if (!name.empty()) {
+        select.emplace_back("-fuse-ld=" + name);
+    }
+
     auto command = comp->command;
-    command.emplace_back("-Wl,--version");
-    auto const & [ret, out, err] = Util::process(command);
+    command.insert(command.end(), select.begin(), select.end());
+
+    auto version_command = command;
+    version_command.emplace_back("-Wl,--version");
+    auto const & [ret, out, err] = Util::process(version_command);
     // TODO: something smarter here
     if (ret != 0) {
-        throw Util::Exceptions::MesonException{"Failed to get linker verison"};
+        throw Util::Exceptions::MesonException{
+            "Failed to get linker version" + (name.empty() ? "" : " for \"" + name + "\"")};
     }
 
-    if (out.find("GNU ld") != std::string::npos) {
-        GnuBFD linker{command};
-        return std::make_unique<Drivers::Gnu>(linker, comp.get());
+    // mold and lld claim to be compatible with GNU ld, so they have to be
+    // checked for first
+    std::unique_ptr<Linker> linker;
+    if (out.find("mold") != std::string::npos) {
+        linker = std::make_unique<Mold>(command);
+    } else if (out.find("LLD") != std::string::npos) {
+        linker = std::make_unique<LLD>(command);
+    } else if (out.find("GNU gold") != std::string::npos) {
+        linker = std::make_unique<GnuGold>(command);
+    } else if (out.find("GNU ld") != std::string::npos) {
+        linker = std::make_unique<GnuBFD>(command);
+    } else {
+        throw Util::Exceptions::MesonException{"Could not detect the linker used by " +
+                                               comp->id()};
     }
-    assert(false);
+    return std::make_unique<Drivers::Gnu>(std::move(linker), comp.get(), select);
 };
 
 } // namespace
 
 std::unique_ptr<Linker> detect_linker(const std::unique_ptr<Compiler::Compiler> & comp,
-                                      const Machines::Machine & machine) {
-    if (comp->id() == "gcc") {
-        return detect_linker_gcc(comp, machine);
+                                      const Machines::Machine & machine,
+                                      const std::string & name) {
+    if (comp->id() == "gcc" || comp->id() == "clang") {
+        return detect_linker_gnu_driver(comp, machine, name);
     }
-    assert(false);
+    throw Util::Exceptions::MesonException{"No linker detection for compiler " + comp->id()};
 };
 
 } // namespace MIR::Toolchain::Linker
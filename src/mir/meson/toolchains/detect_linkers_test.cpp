@@ -5,6 +5,7 @@
 #include <gtest/gtest.h>
 
 #include "compiler.hpp"
+#include "exceptions.hpp"
 #include "linker.hpp"
 
 TEST(g_plus_plus, bfd) {
@@ -20,3 +21,34 @@ TEST(g_plus_plus, bfd) {
     ASSERT_NE(link, nullptr);
     ASSERT_EQ(link->id(), "ld.bfd");
 }
+
+TEST(g_plus_plus, gold) {
+    // Skip if we don't have g++ or ld.gold
+    if (system("g++") == 127 || system("ld.gold") == 127) {
+        GTEST_SKIP();
+    }
+    const auto comp = MIR::Toolchain::Compiler::detect_compiler(
+        MIR::Toolchain::Language::CPP, MIR::Machines::Machine::BUILD, {"g++"});
+    ASSERT_NE(comp, nullptr);
+
+    const auto link =
+        MIR::Toolchain::Linker::detect_linker(comp, MIR::Machines::Machine::BUILD, "gold");
+    ASSERT_NE(link, nullptr);
+    ASSERT_EQ(link->id(), "ld.gold");
+
+    const std::vector<std::string> expected{"-fuse-ld=gold", "-Wl,--threads"};
+    ASSERT_EQ(link->always_args(), expected);
+}
+
+TEST(g_plus_plus, unknown_linker) {
+    if (system("g++") == 127) {
+        GTEST_SKIP();
+    }
+    const auto comp = MIR::Toolchain::Compiler::detect_compiler(
+        MIR::Toolchain::Language::CPP, MIR::Machines::Machine::BUILD, {"g++"});
+    ASSERT_NE(comp, nullptr);
+
+    ASSERT_THROW(MIR::Toolchain::Linker::detect_linker(comp, MIR::Machines::Machine::BUILD,
+                                                       "not-a-real-linker"),
+                 Util::Exceptions::MesonException);
+}
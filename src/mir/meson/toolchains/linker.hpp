@@ -43,17 +43,25 @@ class Linker {
     /// Get arguments that should always be used for this linker
     virtual std::vector<std::string> always_args() const = 0;
 
+    /**
+     * Get the arguments to build an index of split debug information
+     *
+     * @returns The arguments, or an empty vector if this linker can't build an index
+     */
+    virtual std::vector<std::string> gdb_index_args() const = 0;
+
   protected:
     Linker(const std::vector<std::string> & c) : _command{c} {};
     const std::vector<std::string> _command;
 };
 
-class GnuBFD : public Linker {
+/**
+ * Base for linkers with a GNU ld compatible command line
+ *
+ * These are always invoked through a compiler driver, never directly.
+ */
+class GnuLike : public Linker {
   public:
-    GnuBFD(const std::vector<std::string> & c) : Linker{c} {};
-    ~GnuBFD(){};
-
-    std::string id() const override { return "ld.bfd"; }
     RSPFileSupport rsp_support() const override final;
     std::string language() const final {
         throw std::exception{}; // "Should be unused"
@@ -62,33 +70,102 @@ class GnuBFD : public Linker {
         throw std::exception{}; // "Should be unused"
     }
     const std::vector<std::string> command() const final { return _command; }
+
+  protected:
+    GnuLike(const std::vector<std::string> & c) : Linker{c} {};
+};
+
+class GnuBFD : public GnuLike {
+  public:
+    GnuBFD(const std::vector<std::string> & c) : GnuLike{c} {};
+    ~GnuBFD(){};
+
+    std::string id() const override { return "ld.bfd"; }
     std::vector<std::string> always_args() const final { return {}; }
+    // ld.bfd has no --gdb-index, only gold, lld, and mold do
+    std::vector<std::string> gdb_index_args() const final { return {}; }
+};
+
+class GnuGold : public GnuLike {
+  public:
+    GnuGold(const std::vector<std::string> & c) : GnuLike{c} {};
+    ~GnuGold(){};
+
+    std::string id() const override { return "ld.gold"; }
+    // gold is single threaded unless asked otherwise
+    std::vector<std::string> always_args() const final { return {"--threads"}; }
+    std::vector<std::string> gdb_index_args() const final { return {"--gdb-index"}; }
+};
+
+class LLD : public GnuLike {
+  public:
+    LLD(const std::vector<std::string> & c) : GnuLike{c} {};
+    ~LLD(){};
+
+    std::string id() const override { return "ld.lld"; }
+    // lld uses all available threads by default
+    std::vector<std::string> always_args() const final { return {}; }
+    std::vector<std::string> gdb_index_args() const final { return {"--gdb-index"}; }
+};
+
+class Mold : public GnuLike {
+  public:
+    Mold(const std::vector<std::string> & c) : GnuLike{c} {};
+    ~Mold(){};
+
+    std::string id() const override { return "ld.mold"; }
+    // mold uses all available threads by default
+    std::vector<std::string> always_args() const final { return {}; }
+    std::vector<std::string> gdb_index_args() const final { return {"--gdb-index"}; }
 };
 
 namespace Drivers {
 
-// TODO: this might have to be a templateized class
+/**
+ * A GCC compatible compiler (gcc or clang) used to drive the linker
+ */
 class Gnu : public Linker {
   public:
-    Gnu(const GnuBFD & l, const Compiler::Compiler * const c)
-        : Linker{{}}, linker{l}, compiler{c} {};
+    /**
+     * @param l The linker being driven
+     * @param c The compiler driving it
+     * @param s Arguments to make the compiler use this linker, such as -fuse-ld=
+     */
+    Gnu(std::unique_ptr<Linker> && l, const Compiler::Compiler * const c,
+        const std::vector<std::string> & s = {})
+        : Linker{{}}, linker{std::move(l)}, compiler{c}, select_args{s} {};
     ~Gnu(){};
 
-    std::string id() const override { return linker.id(); }
+    std::string id() const override { return linker->id(); }
     RSPFileSupport rsp_support() const override final;
     std::string language() const override;
     std::vector<std::string> output_command(const std::string & outfile) const override;
     const std::vector<std::string> command() const final { return compiler->command; }
-    std::vector<std::string> always_args() const final { return {}; }
+    std::vector<std::string> always_args() const final;
+    std::vector<std::string> gdb_index_args() const final;
+
+    /// Get the arguments used to make the compiler use this linker
+    const std::vector<std::string> & selection() const { return select_args; }
 
   private:
-    const GnuBFD linker;
+    const std::unique_ptr<Linker> linker;
     const Compiler::Compiler * const compiler;
+    const std::vector<std::string> select_args;
 };
 
 } // namespace Drivers
 
+/**
+ * Find the linker used by a compiler
+ *
+ * @param comp The compiler that will drive the linker
+ * @param machine The machine to find the linker for
+ * @param name The linker to ask the compiler to use (bfd, gold, lld, mold,
+ *             etc), or an empty string for the compiler's default
+ * @throws Util::Exceptions::MesonException if the linker can't be found
+ */
 std::unique_ptr<Linker> detect_linker(const std::unique_ptr<Compiler::Compiler> & comp,
-                                      const Machines::Machine & machine);
+                                      const Machines::Machine & machine,
+                                      const std::string & name = "");
 
 } // namespace MIR::Toolchain::Linker
@@ -5,10 +5,24 @@
 
 namespace MIR::Toolchain::Linker::Drivers {
 
-RSPFileSupport Gnu::rsp_support() const { return linker.rsp_support(); }
+RSPFileSupport Gnu::rsp_support() const { return linker->rsp_support(); }
 std::string Gnu::language() const { return compiler->language(); }
 std::vector<std::string> Gnu::output_command(const std::string & outfile) const {
     return compiler->output_command(outfile);
 }
+std::vector<std::string> Gnu::always_args() const {
+    std::vector<std::string> args = select_args;
+    for (const auto & a : linker->always_args()) {
+        args.emplace_back("-Wl," + a);
+    }
+    return args;
+}
+std::vector<std::string> Gnu::gdb_index_args() const {
+    std::vector<std::string> args{};
+    for (const auto & a : linker->gdb_index_args()) {
+        args.emplace_back("-Wl," + a);
+    }
+    return args;
+}
 
 } // namespace MIR::Toolchain::Linker::Drivers
@@ -5,6 +5,6 @@
 
 namespace MIR::Toolchain::Linker {
 
-RSPFileSupport GnuBFD::rsp_support() const { return RSPFileSupport::GCC; };
+RSPFileSupport GnuLike::rsp_support() const { return RSPFileSupport::GCC; };
 
 } // namespace MIR::Toolchain::Linker
@@ -1,18 +1,105 @@
 // SPDX-license-identifier: Apache-2.0
 // Copyright © 2021 Intel Corporation
 
+#include <cstdlib>
+#include <filesystem>
+#include <sstream>
+
 #include "toolchain.hpp"
 #include "archiver.hpp"
 #include "compiler.hpp"
 #include "linker.hpp"
+#include "process.hpp"
+
+namespace fs = std::filesystem;
 
 namespace MIR::Toolchain {
 
-Toolchain get_toolchain(const Language & lang, const Machines::Machine & for_machine) {
-    // TODO: handle passing in explicit binary name
-    auto compiler = Compiler::detect_compiler(lang, for_machine);
+namespace {
+
+const std::vector<std::string> KNOWN_LAUNCHERS{"ccache", "sccache"};
+
+bool is_launcher(const std::string & prog) {
+    const auto name = fs::path{prog}.filename().string();
+    for (const auto & l : KNOWN_LAUNCHERS) {
+        if (name == l) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::vector<std::string> split(const std::string & str) {
+    std::vector<std::string> out{};
+    std::istringstream stream{str};
+    std::string word;
+    while (stream >> word) {
+        out.emplace_back(word);
+    }
+    return out;
+}
+
+const char * compiler_env(const Language & lang) {
+    switch (lang) {
+        case Language::CPP:
+            return "CXX";
+    }
+    return nullptr;
+}
+
+const char * linker_env(const Language & lang) {
+    switch (lang) {
+        case Language::CPP:
+            return "CXX_LD";
+    }
+    return nullptr;
+}
+
+} // namespace
+
+Toolchain get_toolchain(const Language & lang, const Machines::Machine & for_machine,
+                        const std::string & launcher_opt, const std::string & ld_opt) {
+    // TODO: handle the cross and native files
+    std::vector<std::string> bins{};
+    std::vector<std::string> launcher{};
+    std::vector<std::string> args{};
+
+    if (const char * env = std::getenv(compiler_env(lang)); env != nullptr) {
+        bins = split(env);
+        // Allow `CXX="ccache g++"`, splitting the launcher off of the compiler
+        if (bins.size() > 1 && is_launcher(bins[0])) {
+            launcher.emplace_back(bins[0]);
+            bins.erase(bins.begin());
+        }
+        // Anything after the compiler is part of its command, like `CXX="g++ -m32"`
+        if (bins.size() > 1) {
+            args.assign(bins.begin() + 1, bins.end());
+            bins.resize(1);
+        }
+    }
+
+    // An explicit option always wins over the environment
+    if (launcher_opt == "none") {
+        launcher.clear();
+    } else if (launcher_opt != "auto") {
+        launcher = split(launcher_opt);
+    } else if (launcher.empty()) {
+        for (const auto & l : KNOWN_LAUNCHERS) {
+            if (auto found = Util::find_program(l); !found.empty()) {
+                launcher.emplace_back(found);
+                break;
+            }
+        }
+    }
+
+    auto compiler = Compiler::detect_compiler(lang, for_machine, bins, launcher, args);
     auto archiver = Archiver::detect_archiver(for_machine);
-    auto linker = Linker::detect_linker(compiler, for_machine);
+    std::string ld = ld_opt;
+    if (const char * env = std::getenv(linker_env(lang)); ld.empty() && env != nullptr) {
+        ld = env;
+    }
+
+    auto linker = Linker::detect_linker(compiler, for_machine, ld);
     return Toolchain{std::move(compiler), std::move(linker), std::move(archiver)};
 };
 
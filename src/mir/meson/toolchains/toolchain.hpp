@@ -35,6 +35,21 @@ class Toolchain {
     std::unique_ptr<Archiver::Archiver> archiver;
 };
 
-Toolchain get_toolchain(const Language & l, const Machines::Machine &);
+/**
+ * Find the toolchain for a language
+ *
+ * The compiler can be set with the standard environment variables (CXX, etc),
+ * which may include a launcher, such as `CXX="ccache g++"`. The linker can be
+ * set with the `-fuse-ld=` value in the matching variable (CXX_LD, etc).
+ *
+ * @param l The language to get a toolchain for
+ * @param m The machine to get the toolchain for
+ * @param launcher The compiler launcher to use, "auto" to find ccache or
+ *                 sccache, or "none" to not use one.
+ * @param ld The linker for the compiler to use (bfd, gold, lld, mold), or an
+ *           empty string for the environment or compiler default
+ */
+Toolchain get_toolchain(const Language & l, const Machines::Machine & m,
+                        const std::string & launcher = "none", const std::string & ld = "");
 
 } // namespace MIR::Toolchain
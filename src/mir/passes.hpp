@@ -7,6 +7,8 @@
 
 #pragma once
 
+#include <map>
+
 #include "machines.hpp"
 #include "mir.hpp"
 #include "state/state.hpp"
@@ -43,9 +45,9 @@ bool machine_lower(BasicBlock *, const MIR::Machines::PerMachine<MIR::Machines::
  * Run complier detection code and replace variables with compiler objects.
  */
 bool insert_compilers(BasicBlock *,
-                      const std::unordered_map<
-                          MIR::Toolchain::Language,
-                          MIR::Machines::PerMachine<std::shared_ptr<MIR::Toolchain::Toolchain>>> &);
+                      const std::map<MIR::Toolchain::Language,
+                                     MIR::Machines::PerMachine<
+                                         std::shared_ptr<MIR::Toolchain::Toolchain>>> &);
 
 /**
  * Lowering for free functions
@@ -12,8 +12,8 @@ namespace MIR::Passes {
 namespace {
 
 using ToolchainMap =
-    std::unordered_map<MIR::Toolchain::Language,
-                       MIR::Machines::PerMachine<std::shared_ptr<MIR::Toolchain::Toolchain>>>;
+    std::map<MIR::Toolchain::Language,
+             MIR::Machines::PerMachine<std::shared_ptr<MIR::Toolchain::Toolchain>>>;
 
 std::optional<Object> replace_compiler(const Object & obj, const ToolchainMap & tc) {
     if (!std::holds_alternative<std::unique_ptr<FunctionCall>>(obj)) {
@@ -2,6 +2,7 @@
 // Copyright © 2021 Dylan Baker
 
 #include <iostream>
+#include <map>
 #include <vector>
 
 #include "exceptions.hpp"
@@ -70,9 +71,9 @@ std::vector<Objects::File> srclist_to_filelist(const std::vector<Object *> & src
     return filelist;
 }
 
-std::unordered_map<Toolchain::Language, std::vector<Arguments::Argument>>
-target_arguments(const std::unique_ptr<FunctionCall> & f, const State::Persistant & pstate) {
-    std::unordered_map<Toolchain::Language, std::vector<Arguments::Argument>> args{};
+Objects::ArgMap target_arguments(const std::unique_ptr<FunctionCall> & f,
+                                 const State::Persistant & pstate) {
+    Objects::ArgMap args{};
 
     // TODO: handle more than just cpp, likely using a loop
     if (f->kw_args.find("cpp_args") != f->kw_args.end()) {
@@ -104,6 +105,94 @@ target_arguments(const std::unique_ptr<FunctionCall> & f, const State::Persistan
     return args;
 }
 
+/**
+ * Get the link_pool_depth keyword argument of a target, if it is set
+ */
+std::optional<uint> target_link_pool_depth(const std::unique_ptr<FunctionCall> & f) {
+    const auto & found = f->kw_args.find("link_pool_depth");
+    if (found == f->kw_args.end()) {
+        return std::nullopt;
+    }
+    const auto & n = std::get_if<std::unique_ptr<Number>>(&found->second);
+    if (n == nullptr || (*n)->value < 0) {
+        throw Util::Exceptions::InvalidArguments{
+            "\"link_pool_depth\" must be a non-negative integer"};
+    }
+    return static_cast<uint>((*n)->value);
+}
+
+/**
+ * Get the install keyword argument of a target, defaulting to false
+ */
+bool target_install(const std::unique_ptr<FunctionCall> & f) {
+    const auto & found = f->kw_args.find("install");
+    if (found == f->kw_args.end()) {
+        return false;
+    }
+    const auto & b = std::get_if<std::unique_ptr<Boolean>>(&found->second);
+    if (b == nullptr) {
+        throw Util::Exceptions::InvalidArguments{"\"install\" must be a boolean"};
+    }
+    return (*b)->value;
+}
+
+/**
+ * Get the cpp_pch keyword argument of a target, if it is set
+ */
+std::optional<Objects::File> target_pch(const std::unique_ptr<FunctionCall> & f,
+                                        const State::Persistant & pstate) {
+    const auto & found = f->kw_args.find("cpp_pch");
+    if (found == f->kw_args.end()) {
+        return std::nullopt;
+    }
+    const auto & obj = found->second;
+    if (const auto s = std::get_if<std::unique_ptr<String>>(&obj); s != nullptr) {
+        return Objects::File{(*s)->value, f->source_dir, false, pstate.source_root,
+                             pstate.build_root};
+    } else if (const auto s = std::get_if<std::unique_ptr<File>>(&obj); s != nullptr) {
+        return (*s)->file;
+    }
+    throw Util::Exceptions::InvalidArguments{"\"cpp_pch\" must be a string or file"};
+}
+
+/**
+ * Get the override_options keyword argument of a target
+ *
+ * These are validated here, so that errors are reported against the target
+ * rather than in the backend.
+ */
+std::map<std::string, std::string> target_override_options(const std::unique_ptr<FunctionCall> & f,
+                                                           const State::Persistant & pstate) {
+    std::map<std::string, std::string> overrides{};
+    const auto & found = f->kw_args.find("override_options");
+    if (found == f->kw_args.end()) {
+        return overrides;
+    }
+
+    std::vector<const Object *> raw{};
+    if (const auto a = std::get_if<std::unique_ptr<Array>>(&found->second); a != nullptr) {
+        for (const auto & o : (*a)->value) {
+            raw.emplace_back(&o);
+        }
+    } else {
+        raw.emplace_back(&found->second);
+    }
+
+    for (const auto & o : raw) {
+        const auto s = std::get_if<std::unique_ptr<String>>(o);
+        const auto n = s == nullptr ? std::string::npos : (*s)->value.find("=");
+        if (n == std::string::npos) {
+            throw Util::Exceptions::InvalidArguments{
+                "\"override_options\" must be strings in the form \"option=value\""};
+        }
+        overrides[(*s)->value.substr(0, n)] = (*s)->value.substr(n + 1);
+    }
+
+    State::override_options(pstate.options, overrides);
+
+    return overrides;
+}
+
 std::optional<Object> lower_executable(const Object & obj, const State::Persistant & pstate) {
     if (!std::holds_alternative<std::unique_ptr<FunctionCall>>(obj)) {
         return std::nullopt;
@@ -134,7 +223,14 @@ std::optional<Object> lower_executable(const Object & obj, const State::Persista
     auto args = target_arguments(f, pstate);
 
     // TODO: machien parameter needs to be set from the native kwarg
-    Objects::Executable exe{name, srcs, Machines::Machine::BUILD, args};
+    Objects::Executable exe{name,
+                            srcs,
+                            Machines::Machine::BUILD,
+                            args,
+                            target_link_pool_depth(f),
+                            target_pch(f, pstate),
+                            target_override_options(f, pstate),
+                            target_install(f)};
 
     return std::make_unique<Executable>(exe);
 }
@@ -169,7 +265,14 @@ std::optional<Object> lower_static_library(const Object & obj, const State::Pers
     auto args = target_arguments(f, pstate);
 
     // TODO: machien parameter needs to be set from the native kwarg
-    Objects::StaticLibrary lib{name, srcs, Machines::Machine::BUILD, args};
+    Objects::StaticLibrary lib{name,
+                               srcs,
+                               Machines::Machine::BUILD,
+                               args,
+                               target_link_pool_depth(f),
+                               target_pch(f, pstate),
+                               target_override_options(f, pstate),
+                               target_install(f)};
 
     return std::make_unique<StaticLibrary>(lib);
 }
@@ -213,10 +316,15 @@ void lower_project(BasicBlock * block, State::Persistant & pstate) {
 
         auto & tc = pstate.toolchains[l];
 
+        // A toolchain loaded from the last configure is used as is
         // TODO: need to do host as well, when that is relavent
-        tc.set(Machines::Machine::BUILD,
-               std::make_shared<Toolchain::Toolchain>(
-                   Toolchain::get_toolchain(l, Machines::Machine::BUILD)));
+        if (tc.build() == nullptr) {
+            tc.set(Machines::Machine::BUILD,
+                   std::make_shared<Toolchain::Toolchain>(
+                       Toolchain::get_toolchain(l, Machines::Machine::BUILD,
+                                                pstate.options.cpp_launcher,
+                                                pstate.options.cpp_ld)));
+        }
         const auto & c = tc.build()->compiler;
 
         // TODO: print the print the full version
@@ -39,6 +39,27 @@ MIR::BasicBlock lower(const std::string & in) {
     return ir;
 }
 
+/// A state with a C++ toolchain for the build machine, which targets need
+MIR::State::Persistant make_pstate() {
+    MIR::State::Persistant pstate{src_root, build_root};
+    pstate.toolchains[MIR::Toolchain::Language::CPP] =
+        std::make_shared<MIR::Toolchain::Toolchain>(MIR::Toolchain::get_toolchain(
+            MIR::Toolchain::Language::CPP, MIR::Machines::Machine::BUILD));
+    return pstate;
+}
+
+/// Lower the source, then the targets in it
+MIR::BasicBlock lower_targets(const std::string & in, MIR::State::Persistant & pstate) {
+    auto irlist = lower(in);
+    EXPECT_TRUE(MIR::Passes::lower_free_functions(&irlist, pstate));
+    return irlist;
+}
+
+/// The target an instruction holds, which must be a T
+template <typename T> const auto & target(const MIR::Object & obj) {
+    return std::get<std::unique_ptr<T>>(obj)->value;
+}
+
 } // namespace
 
 TEST(flatten, basic) {
@@ -235,11 +256,11 @@ TEST(insert_compiler, simple) {
     auto comp = std::make_unique<MIR::Toolchain::Compiler::CPP::Clang>(init);
     auto tc = std::make_shared<MIR::Toolchain::Toolchain>(
         std::move(comp),
-        std::make_unique<MIR::Toolchain::Linker::Drivers::Gnu>(MIR::Toolchain::Linker::GnuBFD{init},
-                                                               comp.get()),
+        std::make_unique<MIR::Toolchain::Linker::Drivers::Gnu>(
+            std::make_unique<MIR::Toolchain::Linker::GnuBFD>(init), comp.get()),
         std::make_unique<MIR::Toolchain::Archiver::Gnu>(init));
-    std::unordered_map<MIR::Toolchain::Language,
-                       MIR::Machines::PerMachine<std::shared_ptr<MIR::Toolchain::Toolchain>>>
+    std::map<MIR::Toolchain::Language,
+             MIR::Machines::PerMachine<std::shared_ptr<MIR::Toolchain::Toolchain>>>
         tc_map{};
     tc_map[MIR::Toolchain::Language::CPP] =
         MIR::Machines::PerMachine<std::shared_ptr<MIR::Toolchain::Toolchain>>{tc};
@@ -257,8 +278,8 @@ TEST(insert_compiler, simple) {
 }
 
 TEST(insert_compiler, unknown_language) {
-    std::unordered_map<MIR::Toolchain::Language,
-                       MIR::Machines::PerMachine<std::shared_ptr<MIR::Toolchain::Toolchain>>>
+    std::map<MIR::Toolchain::Language,
+             MIR::Machines::PerMachine<std::shared_ptr<MIR::Toolchain::Toolchain>>>
         tc_map{};
 
     auto irlist = lower("x = meson.get_compiler('cpp')");
@@ -345,6 +366,65 @@ TEST(static_library, simple) {
     ASSERT_EQ(a.value, "foo");
 }
 
+TEST(executable, link_pool_depth) {
+    auto pstate = make_pstate();
+    const auto irlist =
+        lower_targets("x = executable('exe', 'source.c', link_pool_depth : 1)", pstate);
+
+    const auto & e = target<MIR::Executable>(irlist.instructions.front());
+    ASSERT_EQ(e.link_pool_depth, 1);
+}
+
+TEST(static_library, cpp_pch) {
+    auto pstate = make_pstate();
+    const auto irlist =
+        lower_targets("x = static_library('lib', 'source.cpp', cpp_pch : 'pch/lib.hpp')", pstate);
+
+    const auto & e = target<MIR::StaticLibrary>(irlist.instructions.front());
+    ASSERT_TRUE(e.cpp_pch.has_value());
+    ASSERT_EQ(e.cpp_pch.value().get_name(), "pch/lib.hpp");
+}
+
+TEST(static_library, install) {
+    auto pstate = make_pstate();
+    const auto irlist = lower_targets("x = static_library('lib', 'source.cpp', install : true)\n"
+                                      "y = static_library('internal', 'source.cpp')",
+                                      pstate);
+
+    ASSERT_TRUE(target<MIR::StaticLibrary>(irlist.instructions.front()).install);
+    ASSERT_FALSE(target<MIR::StaticLibrary>(irlist.instructions.back()).install);
+}
+
+TEST(executable, override_options) {
+    auto pstate = make_pstate();
+    const auto irlist = lower_targets(
+        "x = executable('exe', 'source.cpp', override_options : ['unity=on', 'unity_size=8'])",
+        pstate);
+
+    const auto & e = target<MIR::Executable>(irlist.instructions.front());
+    const auto opts = MIR::State::override_options(pstate.options, e.override_options);
+    ASSERT_TRUE(opts.unity);
+    ASSERT_EQ(opts.unity_size, 8);
+}
+
+TEST(executable, override_options_unknown) {
+    auto pstate = make_pstate();
+    auto irlist = lower("x = executable('exe', 'source.cpp', override_options : ['foo=bar'])");
+    ASSERT_THROW(MIR::Passes::lower_free_functions(&irlist, pstate),
+                 Util::Exceptions::MesonException);
+}
+
+TEST(executable, override_options_global) {
+    auto pstate = make_pstate();
+    for (const auto & o : {"backend_max_links=1", "backend_max_archives=1",
+                           "cpp_launcher=ccache", "cpp_ld=gold"}) {
+        auto irlist = lower("x = executable('exe', 'source.cpp', override_options : ['" +
+                            std::string{o} + "'])");
+        ASSERT_THROW(MIR::Passes::lower_free_functions(&irlist, pstate),
+                     Util::Exceptions::InvalidArguments);
+    }
+}
+
 TEST(project, valid) {
     auto irlist = lower("project('foo')");
     MIR::State::Persistant pstate{src_root, build_root};
@@ -1,6 +1,7 @@
 // SPDX-license-identifier: Apache-2.0
 // Copyright © 2021 Dylan Baker
 
+#include <cstdlib>
 #include <iostream>
 
 #include "getopt.h" // XXX: This is probably not permanent
@@ -36,6 +37,38 @@ Verbs:
                 Display this message and exit.
             -D, --define
                 Set a Meson built-in or project option
+            --cache_dir
+                A directory of configures to reuse, which may be shared by
+                several build directories
+            -w, --watch
+                Keep running after configuring, and configure again whenever
+                a build file changes
+            --trace
+                Write the time taken by each part of the configure to a
+                file, in the Chrome trace event format. With --watch the
+                file holds the latest configure.
+
+    Compile:
+        Usage:
+            meson++ compile <builddir> [options]
+
+        build the project with the built in executor, without generating or
+        running a ninja file
+
+        Options:
+            -h, --help
+                Display this message and exit.
+            -D, --define
+                Set a Meson built-in or project option
+            -j, --jobs
+                The number of jobs to run at once
+
+    Daemon:
+        Usage:
+            meson++ daemon
+
+        stay resident, keeping the state of each build directory in memory.
+        While it runs, `meson++ configure` is run by the daemon instead.
 
 )EOF";
 // clang-format on
@@ -46,6 +79,12 @@ Verb get_verb(int & argc, const char * const argv[]) {
 
         if (v == "configure") {
             return Verb::CONFIGURE;
+        } else if (v == "compile") {
+            return Verb::COMPILE;
+        } else if (v == "internal") {
+            return Verb::INTERNAL;
+        } else if (v == "daemon") {
+            return Verb::DAEMON;
         }
 
         std::cerr << "Unknown action:" << v << std::endl;
@@ -55,26 +94,75 @@ Verb get_verb(int & argc, const char * const argv[]) {
     exit(1);
 }
 
-ConfigureOptions get_config_options(int argc, char * argv[]) {
-    ConfigureOptions conf{};
-
-    static const char * const short_opts = "hs:D:";
+/**
+ * Parse the options of a verb that configures the project
+ *
+ * Compile configures in process, so it shares the configure options, and adds
+ * its own. Options that don't belong to the verb are rejected.
+ */
+CompileOptions get_project_options(int argc, char * argv[], const Verb & verb) {
+    CompileOptions opts{};
+    auto & conf = opts.config;
+    const bool compile = verb == Verb::COMPILE;
+
+    static const char * const short_opts = "hs:D:j:w";
     static const option long_opts[] = {
         {"help", no_argument, NULL, 'h'},
         {"source_dir", required_argument, NULL, 's'},
         {"define", required_argument, NULL, 'D'},
+        {"jobs", required_argument, NULL, 'j'},
+        {"cache_dir", required_argument, NULL, 'C'},
+        {"watch", no_argument, NULL, 'w'},
+        {"trace", required_argument, NULL, 'T'},
         {NULL},
     };
 
     // Initialize the sourcedir
     conf.sourcedir = fs::path{"."};
+    opts.jobs = 0;
 
     int c;
     while ((c = getopt_long(argc, argv, short_opts, long_opts, NULL)) != -1) {
         switch (c) {
+            case 'j': {
+                if (!compile) {
+                    std::cout << usage << std::endl;
+                    exit(1);
+                }
+                char * end;
+                const auto jobs = std::strtol(optarg, &end, 10);
+                if (*end != '\0' || jobs < 0) {
+                    std::cerr << "jobs must be a positive number, not \"" << optarg << "\""
+                              << std::endl;
+                    exit(1);
+                }
+                opts.jobs = jobs;
+                break;
+            }
             case 's':
                 conf.sourcedir = fs::path{optarg};
                 break;
+            case 'C':
+                if (compile) {
+                    std::cout << usage << std::endl;
+                    exit(1);
+                }
+                conf.cache_dir = fs::path{optarg};
+                break;
+            case 'w':
+                if (compile) {
+                    std::cout << usage << std::endl;
+                    exit(1);
+                }
+                conf.watch = true;
+                break;
+            case 'T':
+                if (compile) {
+                    std::cout << usage << std::endl;
+                    exit(1);
+                }
+                conf.trace = fs::path{optarg};
+                break;
             case 'D': {
                 const std::string d{optarg};
                 const auto n = d.find("=");
@@ -100,14 +188,31 @@ ConfigureOptions get_config_options(int argc, char * argv[]) {
     // ++ here to pass the verb
     int i = ++optind;
     if (i >= argc) {
-        std::cerr << "missing required positional argument to 'meson++ configure': <builddir>"
-                  << std::endl;
+        std::cerr << "missing required positional argument to 'meson++ "
+                  << (compile ? "compile" : "configure") << "': <builddir>" << std::endl;
         std::cout << usage << std::endl;
         exit(1);
     }
     conf.builddir = fs::path{argv[i++]};
 
-    return conf;
+    return opts;
+}
+
+ConfigureOptions get_config_options(int argc, char * argv[]) {
+    return get_project_options(argc, argv, Verb::CONFIGURE).config;
+}
+
+CompileOptions get_compile_options(int argc, char * argv[]) {
+    return get_project_options(argc, argv, Verb::COMPILE);
+}
+
+InternalOptions get_internal_options(int argc, char * argv[]) {
+    if (argc < 3) {
+        std::cerr << "missing required positional argument to 'meson++ internal': <command>"
+                  << std::endl;
+        exit(1);
+    }
+    return InternalOptions{argv[2], std::vector<std::string>{argv + 3, argv + argc}};
 }
 
 } // namespace
@@ -124,6 +229,19 @@ Options parse_opts(int argc, char * argv[]) {
     switch (opts.verb) {
         case Verb::CONFIGURE:
             opts.config = get_config_options(argc, argv);
+            break;
+        case Verb::COMPILE:
+            opts.compile = get_compile_options(argc, argv);
+            break;
+        case Verb::INTERNAL:
+            opts.internal = get_internal_options(argc, argv);
+            break;
+        case Verb::DAEMON:
+            if (argc > 2) {
+                std::cout << usage << std::endl;
+                exit(1);
+            }
+            break;
     }
 
     return opts;
@@ -8,8 +8,9 @@
 #pragma once
 
 #include <filesystem>
+#include <map>
 #include <string>
-#include <unordered_map>
+#include <vector>
 
 namespace {
 
@@ -22,6 +23,11 @@ namespace Options {
 /// Which action we're taking
 enum class Verb {
     CONFIGURE,
+    COMPILE,
+    /// Helpers run by the generated build files, not meant to be used directly
+    INTERNAL,
+    /// Stay resident, and run configures sent over a socket
+    DAEMON,
 };
 
 /**
@@ -30,7 +36,33 @@ enum class Verb {
 struct ConfigureOptions {
     fs::path builddir;
     fs::path sourcedir;
-    std::unordered_map<std::string, std::string> options;
+    std::map<std::string, std::string> options;
+    /// A cache of configures to restore from and add to, or empty for none
+    fs::path cache_dir;
+    /// Keep running, and configure again whenever a build file changes
+    bool watch;
+    /// A file to write a Chrome trace of the configure to, or empty for none
+    fs::path trace;
+};
+
+/**
+ * Options for the compile command
+ */
+struct CompileOptions {
+    /// The project is configured in process, so this takes the configure options too
+    ConfigureOptions config;
+    /// The number of jobs to run at once, 0 for the default
+    uint jobs;
+};
+
+/**
+ * Options for the internal commands
+ */
+struct InternalOptions {
+    /// The name of the internal command to run
+    std::string command;
+    /// The arguments to the command
+    std::vector<std::string> arguments;
 };
 
 /**
@@ -40,6 +72,8 @@ struct Options {
     Verb verb;
     // TODO: probably this should be stored in a union of some kind?
     ConfigureOptions config;
+    CompileOptions compile;
+    InternalOptions internal;
 };
 
 /// Parse options and return an Options object
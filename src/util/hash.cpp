@@ -0,0 +1,35 @@
+// SPDX-license-identifier: Apache-2.0
+// Copyright © 2021 Intel Corporation
+
+#include "hash.hpp"
+
+namespace Util {
+
+// FNV-1a, the inputs are short so it doesn't need to be any faster
+void Hasher::bytes(const void * data, std::size_t size) {
+    const auto * p = static_cast<const unsigned char *>(data);
+    for (std::size_t i = 0; i < size; ++i) {
+        state = (state ^ p[i]) * 0x100000001b3ull;
+    }
+}
+
+Hasher & Hasher::add(const uint64_t & value) {
+    bytes(&value, sizeof(value));
+    return *this;
+}
+
+Hasher & Hasher::add(std::string_view str) {
+    add(static_cast<uint64_t>(str.size()));
+    bytes(str.data(), str.size());
+    return *this;
+}
+
+Hasher & Hasher::add(const std::vector<std::string> & strs) {
+    add(static_cast<uint64_t>(strs.size()));
+    for (const auto & s : strs) {
+        add(s);
+    }
+    return *this;
+}
+
+} // namespace Util
@@ -0,0 +1,40 @@
+// SPDX-license-identifier: Apache-2.0
+// Copyright © 2021 Intel Corporation
+
+/**
+ * Stable hashing, for keys that are stored in the build directory
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Util {
+
+/**
+ * An incremental 64 bit hash
+ *
+ * Unlike std::hash this is the same between runs and standard libraries, so
+ * it can be written to disk. Strings are length prefixed, so that `{"ab",
+ * "c"}` and `{"a", "bc"}` hash differently.
+ */
+class Hasher {
+  public:
+    Hasher() : state{0xcbf29ce484222325ull} {};
+
+    Hasher & add(std::string_view str);
+    Hasher & add(const std::vector<std::string> & strs);
+    Hasher & add(const uint64_t & value);
+
+    uint64_t digest() const { return state; }
+
+  private:
+    void bytes(const void * data, std::size_t size);
+
+    uint64_t state;
+};
+
+} // namespace Util
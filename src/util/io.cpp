@@ -0,0 +1,123 @@
+// SPDX-license-identifier: Apache-2.0
+// Copyright © 2021 Intel Corporation
+
+#include <fcntl.h>
+#include <fstream>
+#include <iterator>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "exceptions.hpp"
+#include "io.hpp"
+
+namespace Util {
+
+bool write_if_changed(const std::filesystem::path & path, const std::string & contents) {
+    std::error_code ec{};
+    const auto size = std::filesystem::file_size(path, ec);
+    if (!ec && size == contents.size()) {
+        std::ifstream in{path, std::ios::in | std::ios::binary};
+        const std::string existing{std::istreambuf_iterator<char>{in},
+                                   std::istreambuf_iterator<char>{}};
+        if (existing == contents) {
+            return false;
+        }
+    }
+
+    std::ofstream out{path, std::ios::out | std::ios::binary | std::ios::trunc};
+    if (!out) {
+        throw Exceptions::MesonException{"Could not open " + path.string() + " for writing"};
+    }
+    out << contents;
+    out.close();
+    return true;
+}
+
+void clone_file(const std::filesystem::path & from, const std::filesystem::path & to) {
+    {
+        const MappedFile src{from};
+        const MappedFile dest{to};
+        if (!dest.contents().empty() && src.contents() == dest.contents()) {
+            return;
+        }
+    }
+
+    const int in = open(from.c_str(), O_RDONLY | O_CLOEXEC);
+    if (in < 0) {
+        throw Exceptions::MesonException{"Could not open " + from.string()};
+    }
+    const int out = open(to.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+    if (out < 0) {
+        close(in);
+        throw Exceptions::MesonException{"Could not open " + to.string() + " for writing"};
+    }
+    const bool cloned = ioctl(out, FICLONE, in) == 0;
+    close(out);
+    close(in);
+
+    if (!cloned) {
+        std::error_code ec{};
+        std::filesystem::copy_file(from, to, std::filesystem::copy_options::overwrite_existing,
+                                   ec);
+        if (ec) {
+            throw Exceptions::MesonException{"Could not copy " + from.string() + " to " +
+                                             to.string() + ": " + ec.message()};
+        }
+    }
+}
+
+MappedFile::MappedFile(const std::filesystem::path & path) : data{nullptr}, size{0} {
+    const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return;
+    }
+    struct stat st;
+    // An empty file can't be mapped, and has nothing to map anyway
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        void * addr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr != MAP_FAILED) {
+            data = static_cast<const char *>(addr);
+            size = st.st_size;
+        }
+    }
+    close(fd);
+}
+
+MappedFile::~MappedFile() {
+    if (data != nullptr) {
+        munmap(const_cast<char *>(data), size);
+    }
+}
+
+void write_json_string(const std::string & str, std::ostream & out) {
+    out << '"';
+    for (const auto & c : str) {
+        switch (c) {
+            case '"':
+                out << "\\\"";
+                break;
+            case '\\':
+                out << "\\\\";
+                break;
+            case '\n':
+                out << "\\n";
+                break;
+            case '\t':
+                out << "\\t";
+                break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    constexpr char hex[] = "0123456789abcdef";
+                    out << "\\u00" << hex[(c >> 4) & 0xf] << hex[c & 0xf];
+                } else {
+                    out << c;
+                }
+        }
+    }
+    out << '"';
+}
+
+} // namespace Util
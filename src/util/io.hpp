@@ -0,0 +1,65 @@
+// SPDX-license-identifier: Apache-2.0
+// Copyright © 2021 Intel Corporation
+
+/**
+ * Helpers for reading and writing files
+ */
+
+#pragma once
+
+#include <filesystem>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+namespace Util {
+
+/**
+ * Write contents to a file, but only if they differ from what is already there
+ *
+ * Leaving an unchanged file alone keeps its mtime, so that tools watching it
+ * (ninja, clangd, etc) don't see a spurious change.
+ *
+ * @param path The file to write
+ * @param contents The full contents of the file
+ * @returns true if the file was written, false if it was left untouched
+ */
+bool write_if_changed(const std::filesystem::path & path, const std::string & contents);
+
+/**
+ * Copy a file, sharing its storage with the original where possible
+ *
+ * On filesystems with reflinks (btrfs, XFS) this is nearly free, otherwise
+ * the contents are copied. An existing destination with the same contents is
+ * left alone, as with `write_if_changed`.
+ *
+ * @throws Exceptions::MesonException if the file cannot be copied
+ */
+void clone_file(const std::filesystem::path & from, const std::filesystem::path & to);
+
+/**
+ * A file mapped read only into memory
+ *
+ * This avoids copying files which are read once, straight through. If the
+ * file doesn't exist or can't be mapped the contents are empty.
+ */
+class MappedFile {
+  public:
+    MappedFile(const std::filesystem::path & path);
+    MappedFile(const MappedFile &) = delete;
+    MappedFile & operator=(const MappedFile &) = delete;
+    ~MappedFile();
+
+    std::string_view contents() const { return {data, size}; }
+
+  private:
+    const char * data;
+    std::size_t size;
+};
+
+/**
+ * Write a string as a JSON string value, quoted and escaped
+ */
+void write_json_string(const std::string & str, std::ostream & out);
+
+} // namespace Util
@@ -2,17 +2,23 @@
 // Copyright © 2021 Intel Corporation
 
 #include <array>
+#include <cerrno>
+#include <cstdlib>
 #include <cstring>
 #include <iostream>
+#include <sstream>
 #include <thread>
 
 // TODO: a windows version of this.
+#include <fcntl.h>
 #include <poll.h>
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <unistd.h>
 
+#include "exceptions.hpp"
 #include "process.hpp"
+#include "trace.hpp"
 
 namespace Util {
 
@@ -22,6 +28,15 @@ namespace Util {
 namespace {}
 
 Result process(const std::vector<std::string> & cmd) {
+    const auto trace_args = [&] {
+        std::string argv{};
+        for (const auto & c : cmd) {
+            argv += (argv.empty() ? "" : " ") + c;
+        }
+        return Trace::Args{{"argv", argv}};
+    };
+    const Trace::Span span{"process", trace_args};
+
     std::string out{}, err{};
     int out_pipes[2];
     int err_pipes[2];
@@ -114,4 +129,93 @@ Result process(const std::vector<std::string> & cmd) {
     return Result{status, out, err};
 };
 
+std::string find_program(const std::string & name) {
+    const char * path = std::getenv("PATH");
+    if (path == nullptr) {
+        return "";
+    }
+    std::istringstream stream{path};
+    std::string dir;
+    while (std::getline(stream, dir, ':')) {
+        const auto candidate = (std::filesystem::path{dir.empty() ? "." : dir} / name).string();
+        if (access(candidate.c_str(), X_OK) == 0) {
+            return candidate;
+        }
+    }
+    return "";
+}
+
+Subprocess::Subprocess(const std::vector<std::string> & cmd, const std::filesystem::path & cwd) {
+    // Everything the child needs is allocated before forking, as only async
+    // signal safe functions may be called in the child of a threaded process.
+    std::vector<char *> c_cmd{};
+    c_cmd.reserve(cmd.size() + 1);
+    for (const auto & c : cmd) {
+        c_cmd.emplace_back(const_cast<char *>(c.c_str()));
+    }
+    c_cmd.emplace_back(nullptr);
+    const std::string c_cwd = cwd.string();
+
+    int pipes[2];
+    if (pipe2(pipes, O_CLOEXEC) != 0) {
+        throw Exceptions::MesonException{"Could not create pipe: " +
+                                         std::string{strerror(errno)}};
+    }
+
+    pid = fork();
+    if (pid == -1) {
+        close(pipes[READ]);
+        close(pipes[WRITE]);
+        throw Exceptions::MesonException{"Could not start process: " +
+                                         std::string{strerror(errno)}};
+    }
+    if (pid == 0) {
+        // dup2 clears O_CLOEXEC on the new descriptors
+        dup2(pipes[WRITE], STDOUT_FILENO);
+        dup2(pipes[WRITE], STDERR_FILENO);
+        if (chdir(c_cwd.c_str()) != 0) {
+            _exit(127);
+        }
+        execvp(c_cmd[0], c_cmd.data());
+        const char msg[] = "Program failed to execute\n";
+        [[maybe_unused]] const auto ret = write(STDERR_FILENO, msg, sizeof(msg) - 1);
+        _exit(127);
+    }
+
+    close(pipes[WRITE]);
+    fd = pipes[READ];
+}
+
+Subprocess::~Subprocess() {
+    if (fd != -1) {
+        close(fd);
+        kill(pid, SIGKILL);
+        waitpid(pid, nullptr, 0);
+    }
+}
+
+std::tuple<int, std::string> Subprocess::wait() {
+    std::string out{};
+    std::array<char, 16384> buffer{};
+    while (true) {
+        const auto count = read(fd, buffer.data(), buffer.size());
+        if (count > 0) {
+            out.append(buffer.data(), count);
+        } else if (count == 0 || errno != EINTR) {
+            break;
+        }
+    }
+    close(fd);
+    fd = -1;
+
+    int status;
+    while (waitpid(pid, &status, 0) == -1 && errno == EINTR)
+        ;
+
+    if (WIFSIGNALED(status)) {
+        return {128 + WTERMSIG(status), out};
+    }
+    return {WEXITSTATUS(status), out};
+}
+
 } // namespace Util
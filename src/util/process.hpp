@@ -8,8 +8,10 @@
 #pragma once
 
 #include <cstdint>
+#include <filesystem>
 #include <string>
 #include <tuple>
+#include <sys/types.h>
 #include <vector>
 
 namespace Util {
@@ -29,4 +31,46 @@ typedef std::tuple<int8_t, std::string, std::string> Result;
  */
 Result process(const std::vector<std::string> &);
 
+/**
+ * Find an executable in the PATH
+ *
+ * @returns The path to the executable, or an empty string if it isn't found
+ */
+std::string find_program(const std::string & name);
+
+/**
+ * A process started asynchronously
+ *
+ * The process is started on construction, and runs until wait() is called,
+ * allowing the caller to do other work (or start more processes) in the
+ * meantime. Stdout and stderr are combined, as a build tool wants them
+ * interleaved in the order they were written.
+ */
+class Subprocess {
+  public:
+    /**
+     * Start a process
+     *
+     * @param cmd The command to run, the first element is looked up in the PATH
+     * @param cwd The directory to run the command in
+     * @throws Exceptions::MesonException if the process cannot be started
+     */
+    Subprocess(const std::vector<std::string> & cmd, const std::filesystem::path & cwd);
+    ~Subprocess();
+
+    Subprocess(const Subprocess &) = delete;
+    Subprocess & operator=(const Subprocess &) = delete;
+
+    /**
+     * Read all of the output and wait for the process to exit
+     *
+     * @returns The exit code, 128 + the signal number if it was killed, and the output
+     */
+    std::tuple<int, std::string> wait();
+
+  private:
+    pid_t pid;
+    int fd;
+};
+
 }; // namespace Util
@@ -0,0 +1,90 @@
+// SPDX-license-identifier: Apache-2.0
+// Copyright © 2021 Intel Corporation
+
+/**
+ * Helpers for the binary files kept in the build directory
+ *
+ * These are only ever read by the same machine that wrote them, so values are
+ * written in native byte order, and strings are prefixed with their length.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace Util {
+
+/**
+ * Reads values out of a buffer, failing safely at the end of it
+ */
+class Reader {
+  public:
+    Reader(std::string_view b) : buf{b}, pos{0} {};
+
+    template <typename T> bool read(T & value) {
+        static_assert(std::is_trivially_copyable<T>::value, "Must be trivially copyable");
+        if (pos + sizeof(T) > buf.size()) {
+            return false;
+        }
+        std::memcpy(&value, buf.data() + pos, sizeof(T));
+        pos += sizeof(T);
+        return true;
+    }
+
+    bool read(std::string & value) {
+        uint32_t len;
+        if (!read(len) || pos + len > buf.size()) {
+            return false;
+        }
+        value.assign(buf.data() + pos, len);
+        pos += len;
+        return true;
+    }
+
+    bool read(std::vector<std::string> & value) {
+        uint32_t count;
+        if (!read(count) || count > buf.size() - pos) {
+            return false;
+        }
+        value.resize(count);
+        for (auto & v : value) {
+            if (!read(v)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool done() const { return pos == buf.size(); }
+
+  private:
+    const std::string_view buf;
+    std::size_t pos;
+};
+
+template <typename T> void write(std::ostream & out, const T & value) {
+    static_assert(std::is_trivially_copyable<T>::value, "Must be trivially copyable");
+    out.write(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+inline void write(std::ostream & out, const std::string & str) {
+    const uint32_t len = str.size();
+    write(out, len);
+    out.write(str.data(), len);
+}
+
+inline void write(std::ostream & out, const std::vector<std::string> & strs) {
+    const uint32_t count = strs.size();
+    write(out, count);
+    for (const auto & s : strs) {
+        write(out, s);
+    }
+}
+
+} // namespace Util
@@ -0,0 +1,48 @@
+// SPDX-license-identifier: Apache-2.0
+// Copyright © 2021 Intel Corporation
+
+/**
+ * Scratch directories, mainly for tests
+ */
+
+#pragma once
+
+#include <filesystem>
+#include <stdlib.h>
+#include <string>
+
+#include "exceptions.hpp"
+
+namespace Util {
+
+/**
+ * A new, empty directory which is removed with everything in it on destruction
+ *
+ * The name is picked by mkdtemp, so it is unique even when the same test runs
+ * several times at once.
+ */
+class TempDir {
+  public:
+    /// @throws Exceptions::MesonException if the directory cannot be created
+    TempDir(const std::string & prefix) {
+        std::string tmpl = (std::filesystem::temp_directory_path() / (prefix + "-XXXXXX")).string();
+        if (mkdtemp(tmpl.data()) == nullptr) {
+            throw Exceptions::MesonException{"Could not create a temporary directory for " +
+                                             prefix};
+        }
+        dir = tmpl;
+    }
+    TempDir(const TempDir &) = delete;
+    TempDir & operator=(const TempDir &) = delete;
+    ~TempDir() {
+        std::error_code ec{};
+        std::filesystem::remove_all(dir, ec);
+    }
+
+    const std::filesystem::path & path() const { return dir; }
+
+  private:
+    std::filesystem::path dir;
+};
+
+} // namespace Util
@@ -0,0 +1,65 @@
+// SPDX-license-identifier: Apache-2.0
+// Copyright © 2021 Intel Corporation
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "threads.hpp"
+
+namespace Util {
+
+void parallel_for(const std::size_t & count, const std::function<void(std::size_t)> & func) {
+    const std::size_t workers =
+        std::min<std::size_t>(count, std::max(1u, std::thread::hardware_concurrency()));
+
+    // Not worth the cost of starting threads
+    if (workers <= 1) {
+        for (std::size_t i = 0; i < count; ++i) {
+            func(i);
+        }
+        return;
+    }
+
+    std::atomic<std::size_t> next{0};
+    std::atomic<bool> failed{false};
+    std::exception_ptr error{nullptr};
+    std::mutex error_lock{};
+
+    const auto worker = [&]() {
+        while (!failed) {
+            const std::size_t i = next++;
+            if (i >= count) {
+                return;
+            }
+            try {
+                func(i);
+            } catch (...) {
+                std::lock_guard<std::mutex> guard{error_lock};
+                if (!failed.exchange(true)) {
+                    error = std::current_exception();
+                }
+            }
+        }
+    };
+
+    // The calling thread does its share of the work too
+    std::vector<std::thread> threads{};
+    threads.reserve(workers - 1);
+    for (std::size_t i = 1; i < workers; ++i) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto & t : threads) {
+        t.join();
+    }
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+} // namespace Util
@@ -0,0 +1,31 @@
+// SPDX-license-identifier: Apache-2.0
+// Copyright © 2021 Intel Corporation
+
+/**
+ * Helpers for running work in parallel
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+namespace Util {
+
+/**
+ * Call a function once for each index in [0, count), spread across a pool of threads
+ *
+ * Indexes are handed out to the workers one at a time, so uneven amounts of
+ * work per index balance out. The callback must be safe to call concurrently,
+ * and results should be stored by index so that the caller can consume them
+ * in a deterministic order.
+ *
+ * If any call throws, the remaining indexes are skipped and the first
+ * exception is rethrown once all of the workers have stopped.
+ *
+ * @param count The number of indexes to process
+ * @param func The function to call for each index
+ */
+void parallel_for(const std::size_t & count, const std::function<void(std::size_t)> & func);
+
+} // namespace Util
@@ -0,0 +1,108 @@
+// SPDX-license-identifier: Apache-2.0
+// Copyright © 2021 Intel Corporation
+
+#include <atomic>
+#include <fstream>
+#include <mutex>
+#include <unistd.h>
+
+#include "exceptions.hpp"
+#include "io.hpp"
+#include "trace.hpp"
+
+namespace Util::Trace {
+
+namespace {
+
+struct Event {
+    const char * name;
+    Args args;
+    /// Microseconds since tracing started
+    int64_t ts;
+    int64_t dur;
+    uint32_t tid;
+};
+
+std::atomic<bool> recording{false};
+std::mutex lock{};
+std::filesystem::path output{};
+std::chrono::steady_clock::time_point epoch{};
+std::vector<Event> events{};
+
+/// Small, stable thread ids, the process' first thread to record a span is 1
+uint32_t thread_id() {
+    static std::atomic<uint32_t> next{1};
+    thread_local const uint32_t id = next++;
+    return id;
+}
+
+int64_t micros(const std::chrono::steady_clock::duration & d) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(d).count();
+}
+
+} // namespace
+
+void start(const std::filesystem::path & path) {
+    // Fail before doing any work, rather than after
+    if (!std::ofstream{path}) {
+        throw Exceptions::MesonException{"Could not open " + path.string() + " for writing"};
+    }
+    const std::lock_guard<std::mutex> guard{lock};
+    output = path;
+    epoch = std::chrono::steady_clock::now();
+    recording = true;
+}
+
+void write() {
+    if (!recording) {
+        return;
+    }
+    const std::lock_guard<std::mutex> guard{lock};
+
+    std::ofstream out{output};
+    const auto pid = getpid();
+    out << "{\"traceEvents\":[";
+    for (std::size_t i = 0; i < events.size(); ++i) {
+        const auto & e = events[i];
+        out << (i == 0 ? "\n" : ",\n") << "{\"name\":";
+        write_json_string(e.name, out);
+        out << ",\"cat\":\"meson++\",\"ph\":\"X\",\"ts\":" << e.ts << ",\"dur\":" << e.dur
+            << ",\"pid\":" << pid << ",\"tid\":" << e.tid;
+        if (!e.args.empty()) {
+            out << ",\"args\":{";
+            for (std::size_t a = 0; a < e.args.size(); ++a) {
+                out << (a == 0 ? "" : ",");
+                write_json_string(e.args[a].first, out);
+                out << ":";
+                write_json_string(e.args[a].second, out);
+            }
+            out << "}";
+        }
+        out << "}";
+    }
+    out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+    // With --watch this is called after every configure, which would otherwise
+    // grow without bound and repeat the earlier configures in each trace
+    events.clear();
+}
+
+Span::Span(const char * n) : Span{n, {}} {};
+
+Span::Span(const char * n, const std::function<Args()> & a)
+    : name{n}, enabled{recording}, args{enabled && a ? a() : Args{}},
+      begin{enabled ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{}} {
+}
+
+Span::~Span() {
+    if (!enabled) {
+        return;
+    }
+    const auto end = std::chrono::steady_clock::now();
+    const auto tid = thread_id();
+    const std::lock_guard<std::mutex> guard{lock};
+    events.emplace_back(
+        Event{name, std::move(args), micros(begin - epoch), micros(end - begin), tid});
+}
+
+} // namespace Util::Trace
@@ -0,0 +1,63 @@
+// SPDX-license-identifier: Apache-2.0
+// Copyright © 2021 Intel Corporation
+
+/**
+ * Timing of the phases of a configure, in the Chrome trace event format
+ *
+ * The output can be loaded into chrome://tracing or https://ui.perfetto.dev.
+ * Each thread is shown as its own track.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace Util::Trace {
+
+/// Extra values shown for a span, as name and value
+using Args = std::vector<std::pair<std::string, std::string>>;
+
+/**
+ * Start recording spans
+ *
+ * @param path The file to write the trace to
+ * @throws Exceptions::MesonException if the file cannot be written
+ */
+void start(const std::filesystem::path & path);
+
+/**
+ * Write every span recorded since the last write, if tracing was started
+ *
+ * This may be called more than once, each time replacing the file with the
+ * spans that ended since the previous call.
+ */
+void write();
+
+/**
+ * Records the time between its construction and destruction
+ *
+ * When tracing hasn't been started this only checks a flag, so spans can be
+ * left in hot paths. Arguments are built by a callback for the same reason,
+ * which is only called when recording.
+ */
+class Span {
+  public:
+    Span(const char * name);
+    Span(const char * name, const std::function<Args()> & args);
+    Span(const Span &) = delete;
+    Span & operator=(const Span &) = delete;
+    ~Span();
+
+  private:
+    const char * const name;
+    const bool enabled;
+    Args args;
+    std::chrono::steady_clock::time_point begin;
+};
+
+} // namespace Util::Trace
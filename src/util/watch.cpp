@@ -0,0 +1,106 @@
+// SPDX-license-identifier: Apache-2.0
+// Copyright © 2021 Intel Corporation
+
+#include <array>
+#include <cerrno>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include "exceptions.hpp"
+#include "watch.hpp"
+
+namespace Util {
+
+namespace {
+
+/// Everything that can leave a file with new contents, or remove it
+constexpr uint32_t EVENTS = IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_CREATE | IN_DELETE;
+
+} // namespace
+
+Watcher::Watcher() : fd{inotify_init1(IN_NONBLOCK | IN_CLOEXEC)}, dirs{} {
+    if (fd < 0) {
+        throw Exceptions::MesonException{"Could not create an inotify instance"};
+    }
+}
+
+Watcher::~Watcher() { close(fd); }
+
+void Watcher::watch(const std::vector<std::filesystem::path> & files) {
+    std::map<std::filesystem::path, std::set<std::string>> wanted{};
+    for (const auto & f : files) {
+        wanted[f.parent_path()].emplace(f.filename());
+    }
+
+    // Directories that are still wanted keep their watch, so that events queued
+    // while configuring are still read by the next wait
+    for (auto it = dirs.begin(); it != dirs.end();) {
+        auto & [path, names] = it->second;
+        if (auto w = wanted.find(path); w != wanted.end()) {
+            names = std::move(w->second);
+            wanted.erase(w);
+            ++it;
+        } else {
+            inotify_rm_watch(fd, it->first);
+            it = dirs.erase(it);
+        }
+    }
+
+    for (auto & [dir, names] : wanted) {
+        const int wd = inotify_add_watch(fd, dir.c_str(), EVENTS);
+        if (wd < 0) {
+            continue;
+        }
+        dirs[wd] = {dir, std::move(names)};
+    }
+}
+
+void Watcher::read_events(std::set<std::filesystem::path> & changed) {
+    alignas(inotify_event) std::array<char, 4096> buf;
+    while (true) {
+        const ssize_t len = read(fd, buf.data(), buf.size());
+        if (len < 0 && errno == EINTR) {
+            continue;
+        }
+        if (len <= 0) {
+            return;
+        }
+        for (ssize_t i = 0; i < len;) {
+            const auto * event = reinterpret_cast<const inotify_event *>(buf.data() + i);
+            i += sizeof(inotify_event) + event->len;
+            // The directory is gone, so the next watch has to add it again
+            if (event->mask & IN_IGNORED) {
+                dirs.erase(event->wd);
+                continue;
+            }
+            if (event->len == 0) {
+                continue;
+            }
+            const auto d = dirs.find(event->wd);
+            if (d != dirs.end() && d->second.second.count(event->name) != 0) {
+                changed.emplace(d->second.first / event->name);
+            }
+        }
+    }
+}
+
+std::set<std::filesystem::path> Watcher::wait(const std::chrono::milliseconds & debounce) {
+    std::set<std::filesystem::path> changed{};
+    pollfd p{fd, POLLIN, 0};
+
+    // Nothing happens until the first change, then wait for things to settle
+    while (changed.empty()) {
+        if (poll(&p, 1, -1) < 0 && errno != EINTR) {
+            throw Exceptions::MesonException{"Could not wait for inotify events"};
+        }
+        read_events(changed);
+    }
+    while (poll(&p, 1, debounce.count()) > 0) {
+        read_events(changed);
+    }
+
+    return changed;
+}
+
+} // namespace Util
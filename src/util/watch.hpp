@@ -0,0 +1,66 @@
+// SPDX-license-identifier: Apache-2.0
+// Copyright © 2021 Intel Corporation
+
+/**
+ * Waiting for files to change
+ */
+
+#pragma once
+
+#include <chrono>
+#include <filesystem>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace Util {
+
+/**
+ * Watches a set of files for changes, using inotify
+ *
+ * The directories holding the files are watched rather than the files
+ * themselves, as editors commonly save by writing a new file and renaming it
+ * over the old one, which would leave a watch on the file pointing at the old
+ * inode.
+ */
+class Watcher {
+  public:
+    /// @throws Exceptions::MesonException if inotify is not available
+    Watcher();
+    Watcher(const Watcher &) = delete;
+    Watcher & operator=(const Watcher &) = delete;
+    ~Watcher();
+
+    /**
+     * Replace the files being watched
+     *
+     * Files that don't exist yet are watched for being created, as long as
+     * their directory exists. Directories that were already watched are kept,
+     * along with any of their events that have not been read yet.
+     */
+    void watch(const std::vector<std::filesystem::path> & files);
+
+    /**
+     * Block until a watched file changes
+     *
+     * A single save often generates several events, and several files may be
+     * saved at once, so changes are collected until none have arrived for
+     * the length of the debounce.
+     *
+     * @param debounce How long to wait for more changes after each one
+     * @returns Each file that changed, once
+     */
+    std::set<std::filesystem::path> wait(const std::chrono::milliseconds & debounce);
+
+  private:
+    /// Read the pending events, adding the watched files they touch to changed
+    void read_events(std::set<std::filesystem::path> & changed);
+
+    const int fd;
+
+    /// The watched files in each watched directory, by watch descriptor
+    std::map<int, std::pair<std::filesystem::path, std::set<std::string>>> dirs;
+};
+
+} // namespace Util